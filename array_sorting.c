@@ -27,14 +27,12 @@ void generate_random_array(int arr[], int size, int max_value) {
  * @param size Size of the array
  */
 void selection_sort(int arr[], int size) {
-    printf("\n=== Selection Sort ===\n");
-    
     for (int i = 0; i < size - 1; i++) {
         int min_index = i;
         
         // Find the minimum element in the remaining array
         for (int j = i + 1; j < size; j++) {
-            comparison_count++;
+            SORT_COUNT_COMPARISON();
             if (arr[j] < arr[min_index]) {
                 min_index = j;
             }
@@ -45,11 +43,10 @@ void selection_sort(int arr[], int size) {
             int temp = arr[i];
             arr[i] = arr[min_index];
             arr[min_index] = temp;
-            permutation_count++;
+            SORT_COUNT_PERMUTATION();
         }
         
-        printf("Iteration %d: ", i + 1);
-        display_array(arr, size);
+        SORT_TRACE_ARRAY(arr, size, "Iteration %d: ", i + 1);
     }
 }
 
@@ -61,29 +58,26 @@ void selection_sort(int arr[], int size) {
  * @param size Size of the array
  */
 void bubble_sort(int arr[], int size) {
-    printf("\n=== Bubble Sort ===\n");
-    
     for (int i = 0; i < size - 1; i++) {
         bool swapped = false;
         
         for (int j = 0; j < size - i - 1; j++) {
-            comparison_count++;
+            SORT_COUNT_COMPARISON();
             if (arr[j] > arr[j + 1]) {
                 // Swap elements
                 int temp = arr[j];
                 arr[j] = arr[j + 1];
                 arr[j + 1] = temp;
-                permutation_count++;
+                SORT_COUNT_PERMUTATION();
                 swapped = true;
             }
         }
         
-        printf("Iteration %d: ", i + 1);
-        display_array(arr, size);
+        SORT_TRACE_ARRAY(arr, size, "Iteration %d: ", i + 1);
         
         // Early termination if no swaps occurred
         if (!swapped) {
-            printf("Array is already sorted. Terminating early.\n");
+            SORT_TRACE_MESSAGE("Array is already sorted. Terminating early.");
             break;
         }
     }
@@ -97,18 +91,16 @@ void bubble_sort(int arr[], int size) {
  * @param size Size of the array
  */
 void insertion_sort(int arr[], int size) {
-    printf("\n=== Insertion Sort ===\n");
-    
     for (int i = 1; i < size; i++) {
         int key = arr[i];
         int j = i - 1;
         
         // Move elements greater than key one position ahead
         while (j >= 0) {
-            comparison_count++;
+            SORT_COUNT_COMPARISON();
             if (arr[j] > key) {
                 arr[j + 1] = arr[j];
-                permutation_count++;
+                SORT_COUNT_PERMUTATION();
                 j--;
             } else {
                 break;
@@ -117,31 +109,102 @@ void insertion_sort(int arr[], int size) {
         
         arr[j + 1] = key;
         
-        printf("Iteration %d: ", i);
-        display_array(arr, size);
+        SORT_TRACE_ARRAY(arr, size, "Iteration %d: ", i);
     }
 }
 
+/* Ranges at or below this size are finished with insertion sort */
+#define INSERTION_SORT_THRESHOLD 16
+
+/* Ranges above this size pick their pivot with Tukey's ninther */
+#define NINTHER_THRESHOLD 128
+
+/* Elements classified at a time by the block partition (offsets fit a byte) */
+#define PARTITION_BLOCK_SIZE 64
+
+/* Scheme used by partition() */
+static PartitionScheme partition_scheme = PARTITION_LOMUTO;
+
 /**
- * @brief Partition function for Quick Sort
+ * @brief Swap two array elements
+ * @param arr Array holding the elements
+ * @param i Index of the first element
+ * @param j Index of the second element
+ */
+static void swap_elements(int arr[], int i, int j) {
+    int temp = arr[i];
+    arr[i] = arr[j];
+    arr[j] = temp;
+    SORT_COUNT_PERMUTATION();
+}
+
+/**
+ * @brief Index of the median of three elements
+ * @param arr Array holding the elements
+ * @param a, b, c Indices of the candidates
+ * @return Index of the median value
+ */
+static int median_of_three(const int arr[], int a, int b, int c) {
+    SORT_COUNT_COMPARISONS(3);
+    if (arr[a] < arr[b]) {
+        if (arr[b] < arr[c]) {
+            return b;
+        }
+        return (arr[a] < arr[c]) ? c : a;
+    }
+    if (arr[a] < arr[c]) {
+        return a;
+    }
+    return (arr[b] < arr[c]) ? c : b;
+}
+
+/**
+ * @brief Choose a pivot and move it to arr[high]
+ *
+ * Small ranges use the median of the first, middle and last elements;
+ * larger ranges use the median of three such medians (ninther), which
+ * defeats sorted, reversed and organ-pipe inputs.
  * @param arr Array to partition
  * @param low Starting index
  * @param high Ending index
+ */
+static void select_pivot(int arr[], int low, int high) {
+    int size = high - low + 1;
+    int mid = low + size / 2;
+    int pivot;
+    
+    if (size > NINTHER_THRESHOLD) {
+        int step = size / 8;
+        int first = median_of_three(arr, low, low + step, low + 2 * step);
+        int middle = median_of_three(arr, mid - step, mid, mid + step);
+        int last = median_of_three(arr, high - 2 * step, high - step, high);
+        pivot = median_of_three(arr, first, middle, last);
+    } else {
+        pivot = median_of_three(arr, low, mid, high);
+    }
+    
+    if (pivot != high) {
+        swap_elements(arr, pivot, high);
+    }
+}
+
+/**
+ * @brief Lomuto partition of arr[low..high] around the pivot at arr[high]
  * @return Index of the pivot element
  */
-int partition(int arr[], int low, int high) {
+static int lomuto_partition(int arr[], int low, int high) {
     int pivot = arr[high];
     int i = low - 1;
     
     for (int j = low; j < high; j++) {
-        comparison_count++;
+        SORT_COUNT_COMPARISON();
         if (arr[j] < pivot) {
             i++;
             // Swap arr[i] and arr[j]
             int temp = arr[i];
             arr[i] = arr[j];
             arr[j] = temp;
-            permutation_count++;
+            SORT_COUNT_PERMUTATION();
         }
     }
     
@@ -149,150 +212,1614 @@ int partition(int arr[], int low, int high) {
     int temp = arr[i + 1];
     arr[i + 1] = arr[high];
     arr[high] = temp;
-    permutation_count++;
+    SORT_COUNT_PERMUTATION();
     
     return (i + 1);
 }
 
 /**
- * @brief Quick Sort Algorithm
- * Time Complexity: O(n log n) average, O(n²) worst case
- * Space Complexity: O(log n)
+ * @brief Swap misplaced elements recorded by the block partition in pairs
+ * @param first Start of the left block
+ * @param last End (exclusive) of the right block
+ * @param offsets_l Offsets from first of elements >= pivot
+ * @param offsets_r Offsets back from last of elements < pivot
+ * @param num Number of pairs to swap
+ */
+static void swap_offsets(int arr[], int first, int last, const unsigned char offsets_l[],
+                         const unsigned char offsets_r[], int num) {
+    for (int i = 0; i < num; i++) {
+        int l = first + offsets_l[i];
+        int r = last - offsets_r[i];
+        int temp = arr[l];
+        arr[l] = arr[r];
+        arr[r] = temp;
+    }
+    SORT_COUNT_PERMUTATIONS(num);
+}
+
+/**
+ * @brief BlockQuicksort partition of arr[low..high] around the pivot at arr[high]
+ *
+ * Blocks of PARTITION_BLOCK_SIZE elements are scanned from both ends; the
+ * offsets of misplaced elements (>= pivot on the left, < pivot on the
+ * right) are recorded with an unconditional store and a counter increment,
+ * so classifying an element never branches on its value. The recorded
+ * elements are then swapped in pairs. Same contract as lomuto_partition().
+ *
+ * The pivot waits at arr[low] and finally changes places with the last
+ * smaller element: swapping it with the first larger one instead would
+ * leave the smallest key of a sorted right side at its end, a pattern on
+ * which median-of-three keeps picking the second smallest key.
+ * @return Index of the pivot element
+ */
+static int block_partition(int arr[], int low, int high) {
+    int pivot = arr[high];
+    swap_elements(arr, low, high);
+    int first = low + 1;
+    int last = high + 1; // unpartitioned elements are arr[first..last)
+    unsigned char offsets_l[PARTITION_BLOCK_SIZE];
+    unsigned char offsets_r[PARTITION_BLOCK_SIZE];
+    int num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+    
+    while (last - first > 2 * PARTITION_BLOCK_SIZE) {
+        if (num_l == 0) {
+            start_l = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; i++) {
+                offsets_l[num_l] = (unsigned char)i;
+                num_l += !(arr[first + i] < pivot);
+            }
+            SORT_COUNT_COMPARISONS(PARTITION_BLOCK_SIZE);
+        }
+        if (num_r == 0) {
+            start_r = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; i++) {
+                offsets_r[num_r] = (unsigned char)(i + 1);
+                num_r += arr[last - (i + 1)] < pivot;
+            }
+            SORT_COUNT_COMPARISONS(PARTITION_BLOCK_SIZE);
+        }
+        
+        int num = num_l < num_r ? num_l : num_r;
+        swap_offsets(arr, first, last, offsets_l + start_l, offsets_r + start_r, num);
+        num_l -= num;
+        num_r -= num;
+        start_l += num;
+        start_r += num;
+        
+        if (num_l == 0) {
+            first += PARTITION_BLOCK_SIZE;
+        }
+        if (num_r == 0) {
+            last -= PARTITION_BLOCK_SIZE;
+        }
+    }
+    
+    // At most two blocks are left, one of which may still hold offsets:
+    // the unclassified elements become the other (partial) block
+    int unknown = (last - first) - ((num_l > 0 || num_r > 0) ? PARTITION_BLOCK_SIZE : 0);
+    int l_size, r_size;
+    if (num_r > 0) {
+        l_size = unknown;
+        r_size = PARTITION_BLOCK_SIZE;
+    } else if (num_l > 0) {
+        l_size = PARTITION_BLOCK_SIZE;
+        r_size = unknown;
+    } else {
+        l_size = unknown / 2;
+        r_size = unknown - l_size;
+    }
+    
+    if (unknown > 0 && num_l == 0) {
+        start_l = 0;
+        for (int i = 0; i < l_size; i++) {
+            offsets_l[num_l] = (unsigned char)i;
+            num_l += !(arr[first + i] < pivot);
+        }
+        SORT_COUNT_COMPARISONS(l_size);
+    }
+    if (unknown > 0 && num_r == 0) {
+        start_r = 0;
+        for (int i = 0; i < r_size; i++) {
+            offsets_r[num_r] = (unsigned char)(i + 1);
+            num_r += arr[last - (i + 1)] < pivot;
+        }
+        SORT_COUNT_COMPARISONS(r_size);
+    }
+    
+    int num = num_l < num_r ? num_l : num_r;
+    swap_offsets(arr, first, last, offsets_l + start_l, offsets_r + start_r, num);
+    num_l -= num;
+    num_r -= num;
+    start_l += num;
+    start_r += num;
+    if (num_l == 0) {
+        first += l_size;
+    }
+    if (num_r == 0) {
+        last -= r_size;
+    }
+    
+    // Misplaced elements left in one block move to the inner end of the range
+    if (num_l > 0) {
+        while (num_l > 0) {
+            num_l--;
+            swap_elements(arr, first + offsets_l[start_l + num_l], --last);
+        }
+        first = last;
+    }
+    if (num_r > 0) {
+        while (num_r > 0) {
+            num_r--;
+            swap_elements(arr, last - offsets_r[start_r + num_r], first++);
+        }
+    }
+    
+    swap_elements(arr, low, first - 1);
+    return first - 1;
+}
+
+/**
+ * @brief Select the scheme used by partition()
+ * @param scheme PARTITION_LOMUTO (default) or PARTITION_BLOCK
+ */
+void set_partition_scheme(PartitionScheme scheme) {
+    partition_scheme = scheme;
+}
+
+/**
+ * @brief Name of a partition scheme
+ */
+const char* partition_scheme_name(PartitionScheme scheme) {
+    return scheme == PARTITION_BLOCK ? "block" : "lomuto";
+}
+
+/**
+ * @brief Partition function for Quick Sort
+ *
+ * Partitions around a median-of-three (ninther for large ranges) pivot
+ * with the scheme chosen by set_partition_scheme(): Lomuto, whose
+ * "arr[j] < pivot" branch mispredicts about half the time on random
+ * input, or the branchless BlockQuicksort scheme. Either way, elements
+ * before the returned index are smaller than the pivot and elements after
+ * it are not.
+ * @param arr Array to partition
+ * @param low Starting index
+ * @param high Ending index
+ * @return Index of the pivot element
+ */
+int partition(int arr[], int low, int high) {
+    select_pivot(arr, low, high);
+    
+    if (partition_scheme == PARTITION_BLOCK) {
+        return block_partition(arr, low, high);
+    }
+    return lomuto_partition(arr, low, high);
+}
+
+/**
+ * @brief Insertion sort restricted to arr[low..high]
  * @param arr Array to sort
  * @param low Starting index
  * @param high Ending index
  */
-void quick_sort(int arr[], int low, int high) {
-    if (low < high) {
-        int pi = partition(arr, low, high);
+static void insertion_sort_range(int arr[], int low, int high) {
+    for (int i = low + 1; i <= high; i++) {
+        int key = arr[i];
+        int j = i - 1;
         
-        printf("After partitioning (pivot at index %d): ", pi);
-        display_array(arr, high + 1);
+        while (j >= low) {
+            SORT_COUNT_COMPARISON();
+            if (arr[j] > key) {
+                arr[j + 1] = arr[j];
+                SORT_COUNT_PERMUTATION();
+                j--;
+            } else {
+                break;
+            }
+        }
         
-        quick_sort(arr, low, pi - 1);
-        quick_sort(arr, pi + 1, high);
+        arr[j + 1] = key;
     }
 }
 
 /**
- * @brief Merge function for Merge Sort
- * @param arr Array to merge
- * @param left Left boundary
- * @param mid Middle index
- * @param right Right boundary
+ * @brief Size of the ranges the array sorts hand to sort_leaf()
+ * @return The SIMD leaf size when a vector sorting network is available,
+ *         INSERTION_SORT_THRESHOLD otherwise
  */
-void merge_arrays(int arr[], int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
+static int leaf_size(void) {
+    int simd = simd_leaf_size();
+    return simd > INSERTION_SORT_THRESHOLD ? simd : INSERTION_SORT_THRESHOLD;
+}
+
+/**
+ * @brief Sort a small range with the best available leaf kernel
+ *
+ * Uses the vectorized sorting network when the CPU supports one (its
+ * compare-exchanges are not counted), insertion sort otherwise.
+ * @param arr Array to sort
+ * @param low Starting index
+ * @param high Ending index
+ */
+static void sort_leaf(int arr[], int low, int high) {
+    int size = high - low + 1;
     
-    // Create temporary arrays
-    int* left_arr = malloc(n1 * sizeof(int));
-    int* right_arr = malloc(n2 * sizeof(int));
+    if (size <= SIMD_SORT_MAX_BLOCK && simd_leaf_size() > 0) {
+        simd_sort_block((int32_t*)arr + low, (size_t)size);
+    } else {
+        insertion_sort_range(arr, low, high);
+    }
+}
+
+/**
+ * @brief Restore the max-heap property below a node
+ * @param arr Base of the heap
+ * @param root Index of the node to sift down
+ * @param size Number of elements in the heap
+ */
+static void sift_down(int arr[], int root, int size) {
+    int value = arr[root];
     
-    if (!left_arr || !right_arr) {
-        printf("Memory allocation failed!\n");
-        return;
+    while (2 * root + 1 < size) {
+        int child = 2 * root + 1;
+        if (child + 1 < size) {
+            SORT_COUNT_COMPARISON();
+            if (arr[child] < arr[child + 1]) {
+                child++;
+            }
+        }
+        SORT_COUNT_COMPARISON();
+        if (arr[child] <= value) {
+            break;
+        }
+        arr[root] = arr[child];
+        SORT_COUNT_PERMUTATION();
+        root = child;
+    }
+    
+    arr[root] = value;
+}
+
+/**
+ * @brief Heap Sort Algorithm
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(1)
+ * @param arr Array to sort
+ * @param size Size of the array
+ */
+void heap_sort(int arr[], int size) {
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        sift_down(arr, i, size);
     }
     
-    // Copy data to temporary arrays
-    for (int i = 0; i < n1; i++) {
-        left_arr[i] = arr[left + i];
+    for (int end = size - 1; end > 0; end--) {
+        swap_elements(arr, 0, end);
+        sift_down(arr, 0, end);
+    }
+}
+
+/**
+ * @brief Floor of the base-2 logarithm of a positive integer
+ */
+static int floor_log2(int value) {
+    int log = 0;
+    while (value > 1) {
+        value >>= 1;
+        log++;
     }
-    for (int j = 0; j < n2; j++) {
-        right_arr[j] = arr[mid + 1 + j];
+    return log;
+}
+
+/**
+ * @brief Introsort main loop
+ *
+ * Partitions while the depth budget lasts, recursing into the smaller
+ * side and looping on the larger one so the stack stays O(log n). When
+ * the budget runs out the range is heap sorted; ranges of at most leaf
+ * elements go to the sorting network or insertion sort.
+ * @param arr Array to sort
+ * @param low Starting index
+ * @param high Ending index
+ * @param depth_limit Remaining partitioning depth
+ * @param leaf Size at which partitioning stops
+ */
+static void introsort_loop(int arr[], int low, int high, int depth_limit, int leaf) {
+    while (high - low + 1 > leaf) {
+        if (depth_limit == 0) {
+            heap_sort(arr + low, high - low + 1);
+            SORT_TRACE_ARRAY(arr, high + 1, "After heap sort fallback [%d-%d]: ", low, high);
+            return;
+        }
+        depth_limit--;
+        
+        int pi = partition(arr, low, high);
+        
+        SORT_TRACE_ARRAY(arr, high + 1, "After partitioning (pivot at index %d): ", pi);
+        
+        if (pi - low < high - pi) {
+            introsort_loop(arr, low, pi - 1, depth_limit, leaf);
+            low = pi + 1;
+        } else {
+            introsort_loop(arr, pi + 1, high, depth_limit, leaf);
+            high = pi - 1;
+        }
     }
     
-    // Merge the temporary arrays back
-    int i = 0, j = 0, k = left;
+    if (low < high) {
+        sort_leaf(arr, low, high);
+        SORT_TRACE_ARRAY(arr, high + 1, "After leaf sort [%d-%d]: ", low, high);
+    }
+}
+
+/**
+ * @brief Quick Sort Algorithm (introsort)
+ *
+ * Median-of-three/ninther pivots, small ranges finished by a SIMD
+ * sorting network (or insertion sort without vector support), and a heap
+ * sort fallback once the partitioning depth exceeds 2*log2(n).
+ * Time Complexity: O(n log n) worst case
+ * Space Complexity: O(log n)
+ * @param arr Array to sort
+ * @param low Starting index
+ * @param high Ending index
+ */
+void quick_sort(int arr[], int low, int high) {
+    if (low < high) {
+        introsort_loop(arr, low, high, 2 * floor_log2(high - low + 1), leaf_size());
+    }
+}
+
+/* pdq_sort(): partial insertion sort gives up after this many moves */
+#define PDQ_PARTIAL_INSERTION_LIMIT 8
+
+/**
+ * @brief Counted less-than (an inlined plain comparison without SORT_COUNTERS)
+ */
+static inline bool counted_less(int a, int b) {
+    SORT_COUNT_COMPARISON();
+    return a < b;
+}
+
+/**
+ * @brief Order arr[a] <= arr[b]
+ */
+static void sort2(int arr[], int a, int b) {
+    if (counted_less(arr[b], arr[a])) {
+        swap_elements(arr, a, b);
+    }
+}
+
+/**
+ * @brief Order arr[a] <= arr[b] <= arr[c]
+ */
+static void sort3(int arr[], int a, int b, int c) {
+    sort2(arr, a, b);
+    sort2(arr, b, c);
+    sort2(arr, a, b);
+}
+
+/**
+ * @brief Partition arr[lo..hi) around arr[lo], equal keys to the right
+ *
+ * Requires an element not less than the pivot at hi - 1 and, unless lo
+ * is 0, an element not greater than it at lo - 1, so the scans need no
+ * bounds checks.
+ * @param already_partitioned Set when no element had to be moved
+ * @return Final index of the pivot
+ */
+static int pdq_partition_right(int arr[], int lo, int hi, bool* already_partitioned) {
+    int pivot = arr[lo];
+    int first = lo;
+    int last = hi;
     
-    while (i < n1 && j < n2) {
-        comparison_count++;
-        if (left_arr[i] <= right_arr[j]) {
-            arr[k] = left_arr[i];
-            i++;
-        } else {
-            arr[k] = right_arr[j];
-            j++;
+    while (counted_less(arr[++first], pivot)) {
+    }
+    if (first - 1 == lo) {
+        while (first < last && !counted_less(arr[--last], pivot)) {
+        }
+    } else {
+        while (!counted_less(arr[--last], pivot)) {
         }
-        permutation_count++;
-        k++;
     }
     
-    // Copy remaining elements
-    while (i < n1) {
-        arr[k] = left_arr[i];
-        i++;
-        k++;
-        permutation_count++;
+    *already_partitioned = first >= last;
+    
+    while (first < last) {
+        swap_elements(arr, first, last);
+        while (counted_less(arr[++first], pivot)) {
+        }
+        while (!counted_less(arr[--last], pivot)) {
+        }
     }
     
-    while (j < n2) {
-        arr[k] = right_arr[j];
-        j++;
-        k++;
-        permutation_count++;
+    int pivot_pos = first - 1;
+    arr[lo] = arr[pivot_pos];
+    arr[pivot_pos] = pivot;
+    SORT_COUNT_PERMUTATION();
+    return pivot_pos;
+}
+
+/**
+ * @brief Partition arr[lo..hi) around arr[lo], equal keys to the left
+ *
+ * Used when the pivot equals the element before the range: every key in
+ * the range is then >= pivot, so the left side holds exactly the keys
+ * equal to the pivot and never needs sorting again.
+ * @return Final index of the pivot (the last key equal to it)
+ */
+static int pdq_partition_left(int arr[], int lo, int hi) {
+    int pivot = arr[lo];
+    int first = lo;
+    int last = hi;
+    
+    while (counted_less(pivot, arr[--last])) {
+    }
+    if (last + 1 == hi) {
+        while (first < last && !counted_less(pivot, arr[++first])) {
+        }
+    } else {
+        while (!counted_less(pivot, arr[++first])) {
+        }
     }
     
-    printf("After merging: ");
-    display_array(arr, right + 1);
+    while (first < last) {
+        swap_elements(arr, first, last);
+        while (counted_less(pivot, arr[--last])) {
+        }
+        while (!counted_less(pivot, arr[++first])) {
+        }
+    }
     
-    free(left_arr);
-    free(right_arr);
+    arr[lo] = arr[last];
+    arr[last] = pivot;
+    SORT_COUNT_PERMUTATION();
+    return last;
 }
 
 /**
- * @brief Merge Sort Algorithm
- * Time Complexity: O(n log n)
- * Space Complexity: O(n)
- * @param arr Array to sort
- * @param left Left boundary
- * @param right Right boundary
+ * @brief Insertion sort of arr[lo..hi) that gives up after
+ *        PDQ_PARTIAL_INSERTION_LIMIT moves
+ * @return true if the range is now sorted
  */
-void merge_sort(int arr[], int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
+static bool pdq_partial_insertion_sort(int arr[], int lo, int hi) {
+    int moves = 0;
+    
+    for (int i = lo + 1; i < hi; i++) {
+        int key = arr[i];
+        int j = i;
+        
+        while (j > lo && counted_less(key, arr[j - 1])) {
+            arr[j] = arr[j - 1];
+            j--;
+        }
+        arr[j] = key;
+        moves += i - j;
+        SORT_COUNT_PERMUTATIONS(i - j);
         
-        merge_sort(arr, left, mid);
-        merge_sort(arr, mid + 1, right);
-        merge_arrays(arr, left, mid, right);
+        if (moves > PDQ_PARTIAL_INSERTION_LIMIT) {
+            return false;
+        }
     }
+    return true;
 }
 
 /**
- * @brief Comb Sort Algorithm
- * Time Complexity: O(n²) worst case, O(n log n) average
- * Space Complexity: O(1)
- * @param arr Array to sort
- * @param size Size of the array
+ * @brief Swap a few elements of a badly partitioned side to break up the
+ *        pattern that caused it
+ * @param lo, hi Side arr[lo..hi) of at least INSERTION_SORT_THRESHOLD elements
+ *               (sides above NINTHER_THRESHOLD get three swaps per end)
  */
-void comb_sort(int arr[], int size) {
-    printf("\n=== Comb Sort ===\n");
-    
-    int gap = size;
-    bool swapped = true;
+static void pdq_break_patterns(int arr[], int lo, int hi) {
+    int size = hi - lo;
+    int quarter = size / 4;
     
-    while (gap != 1 || swapped) {
-        // Update gap value
-        gap = (gap * 10) / 13;
-        if (gap < 1) {
-            gap = 1;
+    swap_elements(arr, lo, lo + quarter);
+    swap_elements(arr, hi - 1, hi - quarter);
+    if (size > NINTHER_THRESHOLD) {
+        swap_elements(arr, lo + 1, lo + quarter + 1);
+        swap_elements(arr, lo + 2, lo + quarter + 2);
+        swap_elements(arr, hi - 2, hi - quarter - 1);
+        swap_elements(arr, hi - 3, hi - quarter - 2);
+    }
+}
+
+/**
+ * @brief Pattern-defeating quicksort main loop over arr[lo..hi)
+ *
+ * Recurses into the smaller side and loops on the larger one.
+ * @param bad_allowed Unbalanced partitions left before heap sort takes over
+ * @param leftmost Whether arr[lo - 1] is outside the array
+ * @param leaf Size at which partitioning stops
+ */
+static void pdq_loop(int arr[], int lo, int hi, int bad_allowed, bool leftmost, int leaf) {
+    while (hi - lo > leaf) {
+        int size = hi - lo;
+        int mid = lo + size / 2;
+        
+        // Median of three (ninther for large ranges) moved to arr[lo]
+        if (size > NINTHER_THRESHOLD) {
+            sort3(arr, lo, mid, hi - 1);
+            sort3(arr, lo + 1, mid - 1, hi - 2);
+            sort3(arr, lo + 2, mid + 1, hi - 3);
+            sort3(arr, mid - 1, mid, mid + 1);
+            swap_elements(arr, lo, mid);
+        } else {
+            sort3(arr, mid, lo, hi - 1);
         }
         
-        swapped = false;
+        // A pivot equal to the element before the range is the smallest
+        // key present: group its copies on the left and skip them
+        if (!leftmost && !counted_less(arr[lo - 1], arr[lo])) {
+            lo = pdq_partition_left(arr, lo, hi) + 1;
+            SORT_TRACE_ARRAY(arr, hi, "After grouping keys equal to the pivot (up to index %d): ",
+                             lo - 1);
+            continue;
+        }
         
-        for (int i = 0; i < size - gap; i++) {
-            comparison_count++;
-            if (arr[i] > arr[i + gap]) {
-                // Swap elements
-                int temp = arr[i];
-                arr[i] = arr[i + gap];
-                arr[i + gap] = temp;
-                permutation_count++;
-                swapped = true;
+        bool already_partitioned;
+        int pivot_pos = pdq_partition_right(arr, lo, hi, &already_partitioned);
+        int left_size = pivot_pos - lo;
+        int right_size = hi - (pivot_pos + 1);
+        
+        SORT_TRACE_ARRAY(arr, hi, "After partitioning (pivot at index %d): ", pivot_pos);
+        
+        if (left_size < size / 8 || right_size < size / 8) {
+            if (--bad_allowed == 0) {
+                heap_sort(arr + lo, size);
+                SORT_TRACE_ARRAY(arr, hi, "After heap sort fallback [%d-%d]: ", lo, hi - 1);
+                return;
+            }
+            if (left_size >= leaf) {
+                pdq_break_patterns(arr, lo, pivot_pos);
             }
+            if (right_size >= leaf) {
+                pdq_break_patterns(arr, pivot_pos + 1, hi);
+            }
+        } else if (already_partitioned &&
+                   pdq_partial_insertion_sort(arr, lo, pivot_pos) &&
+                   pdq_partial_insertion_sort(arr, pivot_pos + 1, hi)) {
+            // Balanced, no swaps and both sides (nearly) sorted: done
+            SORT_TRACE_ARRAY(arr, hi, "Range [%d-%d] was already sorted: ", lo, hi - 1);
+            return;
         }
         
-        printf("Gap %d: ", gap);
-        display_array(arr, size);
+        if (left_size < right_size) {
+            pdq_loop(arr, lo, pivot_pos, bad_allowed, leftmost, leaf);
+            lo = pivot_pos + 1;
+            leftmost = false;
+        } else {
+            pdq_loop(arr, pivot_pos + 1, hi, bad_allowed, false, leaf);
+            hi = pivot_pos;
+        }
+    }
+    
+    if (hi - lo > 1) {
+        sort_leaf(arr, lo, hi - 1);
+        SORT_TRACE_ARRAY(arr, hi, "After leaf sort [%d-%d]: ", lo, hi - 1);
+    }
+}
+
+/**
+ * @brief Pattern-defeating quicksort (pdqsort)
+ *
+ * Introsort with three additions that target real-world keys:
+ * - keys equal to the pivot are grouped and skipped: when the pivot
+ *   equals the element just before the range, the range is split into
+ *   "== pivot" and "> pivot" and only the latter is sorted further, so
+ *   inputs with few distinct keys take O(n log k) for k distinct keys;
+ * - an unbalanced partition (a side under 1/8 of the range) swaps a few
+ *   elements of each side to break the pattern, and after log2(n) such
+ *   partitions the range is heap sorted;
+ * - a balanced partition that moved nothing tries a bounded insertion sort
+ *   of both sides and stops if they were already sorted, so sorted and
+ *   nearly sorted ranges take O(n).
+ * Time Complexity: O(n log n) worst case, O(n) on sorted input
+ * Space Complexity: O(log n)
+ * @param arr Array to sort
+ * @param size Size of the array
+ */
+void pdq_sort(int arr[], int size) {
+    if (size > 1) {
+        pdq_loop(arr, 0, size, floor_log2(size), true, leaf_size());
+    }
+}
+
+/**
+ * @brief Merge function for Merge Sort
+ *
+ * Merges arr[left..mid] and arr[mid+1..right] in place. Only the left
+ * run is copied out, into a single temporary buffer; if that allocation
+ * fails the array is left untouched.
+ * @param arr Array to merge
+ * @param left Left boundary
+ * @param mid Middle index
+ * @param right Right boundary
+ * @return true on success, false if the temporary buffer could not be allocated
+ */
+bool merge_arrays(int arr[], int left, int mid, int right) {
+    int n1 = mid - left + 1;
+    
+    // Copy the left run to a temporary array
+    int* left_arr = malloc((size_t)n1 * sizeof(int));
+    if (left_arr == NULL) {
+        return false;
+    }
+    memcpy(left_arr, arr + left, (size_t)n1 * sizeof(int));
+    
+    // Merge back; the right run is read in place ahead of the write position
+    int i = 0, j = mid + 1, k = left;
+    
+    while (i < n1 && j <= right) {
+        SORT_COUNT_COMPARISON();
+        if (left_arr[i] <= arr[j]) {
+            arr[k] = left_arr[i];
+            i++;
+        } else {
+            arr[k] = arr[j];
+            j++;
+        }
+        SORT_COUNT_PERMUTATION();
+        k++;
+    }
+    
+    // Copy remaining elements of the left run (the right run is already in place)
+    while (i < n1) {
+        arr[k] = left_arr[i];
+        i++;
+        k++;
+        SORT_COUNT_PERMUTATION();
+    }
+    
+    SORT_TRACE_ARRAY(arr, right + 1, "After merging: ");
+    
+    free(left_arr);
+    return true;
+}
+
+/**
+ * @brief Merge two adjacent sorted runs from one buffer into another
+ * @param src Buffer holding src[lo..mid) and src[mid..hi)
+ * @param dst Buffer receiving the merged run in dst[lo..hi)
+ * @param lo Start of the first run
+ * @param mid Start of the second run
+ * @param hi End of the second run (exclusive)
+ */
+static void merge_runs(const int src[], int dst[], int lo, int mid, int hi) {
+    int i = lo, j = mid, k = lo;
+    
+    while (i < mid && j < hi) {
+        SORT_COUNT_COMPARISON();
+        if (src[i] <= src[j]) {
+            dst[k++] = src[i++];
+        } else {
+            dst[k++] = src[j++];
+        }
+    }
+    
+    while (i < mid) {
+        dst[k++] = src[i++];
+    }
+    while (j < hi) {
+        dst[k++] = src[j++];
+    }
+    
+    SORT_COUNT_PERMUTATIONS((unsigned long long)(hi - lo));
+}
+
+/**
+ * @brief Bottom-up Merge Sort using a caller-provided scratch buffer
+ *
+ * Leaf runs are sorted in place (SIMD sorting network when available,
+ * insertion sort otherwise). With the network, pairs of leaf runs are
+ * also merged in place by simd_merge_block(). Each pass then merges
+ * pairs of runs from one buffer into the other, alternating between arr
+ * and scratch. The data is copied back once at the end if the last pass
+ * wrote into scratch. No allocation is made.
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(1) beyond the scratch buffer
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param scratch Buffer of at least size elements
+ */
+void merge_sort_with_buffer(int arr[], int size, int scratch[]) {
+    int run = leaf_size();
+    size_t pass_bytes = 2 * (size_t)size * sizeof(int);
+    if (simd_leaf_size() > 0 && 2 * run <= SIMD_SORT_MAX_BLOCK) {
+        // Pairs of leaves are merged in registers while they are still in cache
+        for (int lo = 0; lo < size; lo += 2 * run) {
+            if (size - lo >= 2 * run) {
+                sort_leaf(arr, lo, lo + run - 1);
+                sort_leaf(arr, lo + run, lo + 2 * run - 1);
+                simd_merge_block((int32_t*)arr + lo, (size_t)(2 * run));
+            } else {
+                sort_leaf(arr, lo, size - 1);
+            }
+        }
+        run *= 2;
+    } else {
+        for (int lo = 0; lo < size; lo += run) {
+            int hi = lo + run - 1;
+            sort_leaf(arr, lo, hi < size ? hi : size - 1);
+        }
+    }
+    SORT_COUNT_BYTES(pass_bytes);
+    
+    int* src = arr;
+    int* dst = scratch;
+    
+    for (int width = run; width < size; width *= 2) {
+        for (int lo = 0; lo < size; lo += 2 * width) {
+            int mid = (lo + width < size) ? lo + width : size;
+            int hi = (mid + width < size) ? mid + width : size;
+            merge_runs(src, dst, lo, mid, hi);
+        }
+        SORT_COUNT_BYTES(pass_bytes);
+        
+        SORT_TRACE_ARRAY(dst, size, "After merge pass (width %d): ", width);
+        
+        int* temp = src;
+        src = dst;
+        dst = temp;
+    }
+    
+    if (src != arr) {
+        memcpy(arr, src, (size_t)size * sizeof(int));
+        SORT_COUNT_BYTES(pass_bytes);
+    }
+}
+
+/**
+ * @brief Merge Sort Algorithm
+ *
+ * Allocates one scratch buffer for the whole range and runs
+ * merge_sort_with_buffer(). If the allocation fails the array is left
+ * unchanged and an error is reported on stderr.
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(n)
+ * @param arr Array to sort
+ * @param left Left boundary
+ * @param right Right boundary
+ */
+void merge_sort(int arr[], int left, int right) {
+    if (left >= right) {
+        return;
+    }
+    
+    int size = right - left + 1;
+    int* scratch = malloc((size_t)size * sizeof(int));
+    if (scratch == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return;
+    }
+    
+    merge_sort_with_buffer(arr + left, size, scratch);
+    free(scratch);
+}
+
+/**
+ * @brief Comb Sort Algorithm
+ * Time Complexity: O(n²) worst case, O(n log n) average
+ * Space Complexity: O(1)
+ * @param arr Array to sort
+ * @param size Size of the array
+ */
+void comb_sort(int arr[], int size) {
+    int gap = size;
+    bool swapped = true;
+    
+    while (gap != 1 || swapped) {
+        // Update gap value
+        gap = (gap * 10) / 13;
+        if (gap < 1) {
+            gap = 1;
+        }
+        
+        swapped = false;
+        
+        for (int i = 0; i < size - gap; i++) {
+            SORT_COUNT_COMPARISON();
+            if (arr[i] > arr[i + gap]) {
+                // Swap elements
+                int temp = arr[i];
+                arr[i] = arr[i + gap];
+                arr[i + gap] = temp;
+                SORT_COUNT_PERMUTATION();
+                swapped = true;
+            }
+        }
+        
+        SORT_TRACE_ARRAY(arr, size, "Gap %d: ", gap);
+    }
+}
+
+/**
+ * @brief Define an LSD radix sort core for one unsigned key width
+ *
+ * The generated function sorts the keys (key ^ flip) >> low_bit, so
+ * passing the sign bit as flip orders two's-complement signed keys
+ * correctly; bits below low_bit are ignored and, the sort being stable,
+ * keep equal keys in their input order. All
+ * digit histograms are computed in a single pre-pass; passes whose digit
+ * is the same for every key are skipped. Keys ping-pong between arr and
+ * scratch and are copied back once if the last pass wrote into scratch.
+ * Each executed pass adds size to permutation_count.
+ */
+#define RADIX_DEFINE_CORE(name, utype, key_bits) \
+static bool name(utype arr[], size_t size, int digit_bits, utype flip, int low_bit) { \
+    int passes = (key_bits - low_bit + digit_bits - 1) / digit_bits; \
+    size_t buckets = (size_t)1 << digit_bits; \
+    utype mask = (utype)(buckets - 1); \
+    \
+    utype* scratch = malloc(size * sizeof(utype)); \
+    size_t* counts = calloc((size_t)passes * buckets, sizeof(size_t)); \
+    if (scratch == NULL || counts == NULL) { \
+        free(scratch); \
+        free(counts); \
+        return false; \
+    } \
+    \
+    /* One pre-pass builds the histogram of every digit */ \
+    for (size_t i = 0; i < size; i++) { \
+        utype key = arr[i] ^ flip; \
+        for (int p = 0; p < passes; p++) { \
+            counts[(size_t)p * buckets + ((key >> (low_bit + p * digit_bits)) & mask)]++; \
+        } \
+    } \
+    \
+    utype* src = arr; \
+    utype* dst = scratch; \
+    int executed = 0; \
+    \
+    for (int p = 0; p < passes; p++) { \
+        size_t* count = counts + (size_t)p * buckets; \
+        int shift = low_bit + p * digit_bits; \
+        \
+        /* Skip the pass when every key has the same digit */ \
+        if (count[((src[0] ^ flip) >> shift) & mask] == size) { \
+            continue; \
+        } \
+        \
+        /* Turn the histogram into starting offsets */ \
+        size_t offset = 0; \
+        for (size_t b = 0; b < buckets; b++) { \
+            size_t c = count[b]; \
+            count[b] = offset; \
+            offset += c; \
+        } \
+        \
+        for (size_t i = 0; i < size; i++) { \
+            dst[count[((src[i] ^ flip) >> shift) & mask]++] = src[i]; \
+        } \
+        SORT_COUNT_PERMUTATIONS(size); \
+        executed++; \
+        \
+        utype* temp = src; \
+        src = dst; \
+        dst = temp; \
+    } \
+    \
+    if (src != arr) { \
+        memcpy(arr, src, size * sizeof(utype)); \
+    } \
+    \
+    SORT_TRACE_MESSAGE("Radix sort: %d of %d passes executed (%d-bit digits)", \
+                       executed, passes, digit_bits); \
+    \
+    free(scratch); \
+    free(counts); \
+    return true; \
+}
+
+RADIX_DEFINE_CORE(radix_core_32, uint32_t, 32)
+RADIX_DEFINE_CORE(radix_core_64, uint64_t, 64)
+
+/**
+ * @brief Check a radix digit width
+ */
+static bool valid_digit_bits(int digit_bits) {
+    return digit_bits >= 1 && digit_bits <= RADIX_MAX_DIGIT_BITS;
+}
+
+/**
+ * @brief LSD Radix Sort for signed 32-bit keys
+ * Time Complexity: O(n * 32 / digit_bits)
+ * Space Complexity: O(n + 2^digit_bits)
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param digit_bits Digit width in bits (8, 11 and 16 are typical)
+ * @return false if digit_bits is invalid or memory allocation failed
+ *         (the array is left unchanged)
+ */
+bool radix_sort_int32(int32_t arr[], size_t size, int digit_bits) {
+    if (!valid_digit_bits(digit_bits)) {
+        return false;
+    }
+    return size < 2 || radix_core_32((uint32_t*)arr, size, digit_bits, UINT32_C(1) << 31, 0);
+}
+
+/**
+ * @brief LSD Radix Sort for unsigned 32-bit keys
+ * @see radix_sort_int32
+ */
+bool radix_sort_uint32(uint32_t arr[], size_t size, int digit_bits) {
+    if (!valid_digit_bits(digit_bits)) {
+        return false;
+    }
+    return size < 2 || radix_core_32(arr, size, digit_bits, 0, 0);
+}
+
+/**
+ * @brief LSD Radix Sort for signed 64-bit keys
+ * Time Complexity: O(n * 64 / digit_bits)
+ * Space Complexity: O(n + 2^digit_bits)
+ * @see radix_sort_int32
+ */
+bool radix_sort_int64(int64_t arr[], size_t size, int digit_bits) {
+    if (!valid_digit_bits(digit_bits)) {
+        return false;
+    }
+    return size < 2 || radix_core_64((uint64_t*)arr, size, digit_bits, UINT64_C(1) << 63, 0);
+}
+
+/**
+ * @brief LSD Radix Sort for unsigned 64-bit keys
+ * @see radix_sort_int32
+ */
+bool radix_sort_uint64(uint64_t arr[], size_t size, int digit_bits) {
+    if (!valid_digit_bits(digit_bits)) {
+        return false;
+    }
+    return size < 2 || radix_core_64(arr, size, digit_bits, 0, 0);
+}
+
+/**
+ * @brief Stable LSD Radix Sort of unsigned 64-bit words by their bits
+ *        [low_bit, 64) only
+ *
+ * Words with equal high bits keep their input order, so (key, payload)
+ * words packed with the key in the high bits sort by key without paying
+ * passes over the payload bits.
+ * Time Complexity: O(n * (64 - low_bit) / digit_bits)
+ * Space Complexity: O(n + 2^digit_bits)
+ * @see radix_sort_int32
+ * @param low_bit Number of low bits to ignore, in [0, 64)
+ */
+bool radix_sort_uint64_high(uint64_t arr[], size_t size, int digit_bits, int low_bit) {
+    if (!valid_digit_bits(digit_bits) || low_bit < 0 || low_bit >= 64) {
+        return false;
+    }
+    return size < 2 || radix_core_64(arr, size, digit_bits, 0, low_bit);
+}
+
+/**
+ * @brief Radix Sort for int arrays with the default digit width
+ *
+ * If the scratch buffers cannot be allocated the array is sorted with
+ * quick_sort() instead.
+ * Time Complexity: O(n)
+ * Space Complexity: O(n)
+ * @param arr Array to sort
+ * @param size Size of the array
+ */
+void radix_sort(int arr[], int size) {
+    if (size < 2) {
+        return;
+    }
+    if (!radix_sort_int32((int32_t*)arr, (size_t)size, RADIX_DEFAULT_DIGIT_BITS)) {
+        quick_sort(arr, 0, size - 1);
+    }
+}
+
+/* auto_sort(): inputs at or below this size are insertion sorted */
+#define AUTO_SMALL_SIZE 32
+
+/* auto_sort(): pairs (and elements) sampled to estimate inversions (and duplicates) */
+#define AUTO_SAMPLE_SIZE 256
+
+/* auto_sort(): merge the existing runs when they average at least this length */
+#define AUTO_MIN_AVERAGE_RUN 32
+
+/* auto_sort(): nearly sorted means at most this many estimated inversions per element */
+#define AUTO_INVERSIONS_PER_ELEMENT 4
+
+/* auto_sort(): insertion sort gives up after this many moves per element */
+#define AUTO_INSERTION_BUDGET 16
+
+/* auto_sort(): largest key range counted when duplicates dominate */
+#define AUTO_COUNTING_MAX_RANGE (1 << 16)
+
+/* auto_sort(): smallest input handed to radix sort */
+#define AUTO_RADIX_MIN_SIZE 1024
+
+/**
+ * @brief Probe how presorted an int array is, in O(n) time
+ *
+ * One pass counts descents and finds the key range; a second counts the
+ * runs a natural merge sort would see (non-descending, or strictly
+ * descending so reversing keeps equal keys in order), stopping once there
+ * are more than n / AUTO_MIN_AVERAGE_RUN of them. Inversions are estimated from
+ * AUTO_SAMPLE_SIZE pseudo-random pairs and duplicates from a sorted sample
+ * of evenly spaced elements; the sampling uses a fixed seed, so the same
+ * input always gets the same decision.
+ * @param arr Array to probe
+ * @param size Size of the array
+ * @param probe Filled with the measurements (engine and reason are cleared)
+ */
+void probe_presortedness(const int arr[], int size, SortProbe* probe) {
+    memset(probe, 0, sizeof(*probe));
+    probe->size = size;
+    if (size < 1) {
+        return;
+    }
+    
+    int descents = 0;
+    int min_value = arr[0];
+    int max_value = arr[0];
+    for (int i = 1; i < size; i++) {
+        // Branch-free so the pass vectorizes and never mispredicts
+        descents += arr[i - 1] > arr[i];
+        min_value = arr[i] < min_value ? arr[i] : min_value;
+        max_value = arr[i] > max_value ? arr[i] : max_value;
+    }
+    probe->descents = descents;
+    probe->min_value = min_value;
+    probe->max_value = max_value;
+    
+    // Stop once there are too many runs for a run merge to pay off
+    // (small inputs are always counted in full)
+    int max_runs = size / AUTO_MIN_AVERAGE_RUN + AUTO_SMALL_SIZE;
+    for (int i = 0; i < size && probe->runs <= max_runs; ) {
+        int j = i + 1;
+        if (j < size && arr[j] < arr[i]) {
+            while (j < size && arr[j] < arr[j - 1]) {
+                j++;
+            }
+            probe->descending_runs++;
+        } else {
+            while (j < size && arr[j] >= arr[j - 1]) {
+                j++;
+            }
+        }
+        probe->runs++;
+        i = j;
+    }
+    
+    // Inverted fraction of random pairs (LCG, high bits scaled to [0, size))
+    uint32_t state = 0x9E3779B9u;
+    int inverted = 0;
+    for (int s = 0; s < AUTO_SAMPLE_SIZE; s++) {
+        state = state * 1664525u + 1013904223u;
+        int a = (int)(((uint64_t)state * (uint64_t)size) >> 32);
+        state = state * 1664525u + 1013904223u;
+        int b = (int)(((uint64_t)state * (uint64_t)size) >> 32);
+        if ((a < b && arr[a] > arr[b]) || (b < a && arr[b] > arr[a])) {
+            inverted++;
+        }
+    }
+    probe->inversion_ratio = (double)inverted / AUTO_SAMPLE_SIZE;
+    probe->estimated_inversions = probe->inversion_ratio * (double)size * (double)(size - 1) / 2.0;
+    
+    // Equal neighbours in a sorted sample of evenly spaced elements
+    int32_t sample[AUTO_SAMPLE_SIZE];
+    int count = size < AUTO_SAMPLE_SIZE ? size : AUTO_SAMPLE_SIZE;
+    for (int k = 0; k < count; k++) {
+        sample[k] = arr[(long long)k * size / count];
+    }
+    int32_quick_sort(sample, (size_t)count);
+    int equal = 0;
+    for (int k = 1; k < count; k++) {
+        if (sample[k] == sample[k - 1]) {
+            equal++;
+        }
+    }
+    probe->duplicate_ratio = count > 1 ? (double)equal / (count - 1) : 0.0;
+}
+
+/**
+ * @brief Pick the engine for a probed array and record why
+ */
+static SortEngine choose_engine(SortProbe* probe) {
+    int size = probe->size;
+    long long range = (long long)probe->max_value - probe->min_value + 1;
+    
+    if (probe->descents == 0) {
+        probe->reason = "already sorted";
+        return SORT_ENGINE_NONE;
+    }
+    if (size <= AUTO_SMALL_SIZE) {
+        probe->reason = "small input";
+        return SORT_ENGINE_INSERTION;
+    }
+    if (probe->runs <= size / AUTO_MIN_AVERAGE_RUN) {
+        probe->reason = probe->descending_runs > 0 ? "few long runs, some descending"
+                                                   : "few long runs";
+        return SORT_ENGINE_RUN_MERGE;
+    }
+    if (probe->estimated_inversions <= (double)AUTO_INVERSIONS_PER_ELEMENT * size) {
+        probe->reason = "nearly sorted";
+        return SORT_ENGINE_INSERTION;
+    }
+    if (range <= size ||
+        (range <= AUTO_COUNTING_MAX_RANGE && probe->duplicate_ratio >= 0.5)) {
+        probe->reason = "small key range";
+        return SORT_ENGINE_COUNTING;
+    }
+    if (size >= AUTO_RADIX_MIN_SIZE) {
+        probe->reason = "large input, wide key range";
+        return SORT_ENGINE_RADIX;
+    }
+    probe->reason = "no exploitable order";
+    return SORT_ENGINE_INTROSORT;
+}
+
+/**
+ * @brief Insertion sort that gives up once it has moved `budget` elements
+ * @return false if the budget ran out (the array is then partly sorted)
+ */
+static bool insertion_sort_bounded(int arr[], int size, long long budget) {
+    for (int i = 1; i < size; i++) {
+        int key = arr[i];
+        int j = i - 1;
+        
+        while (j >= 0) {
+            SORT_COUNT_COMPARISON();
+            if (arr[j] <= key) {
+                break;
+            }
+            arr[j + 1] = arr[j];
+            SORT_COUNT_PERMUTATION();
+            j--;
+            if (--budget < 0) {
+                arr[j + 1] = key;
+                return false;
+            }
+        }
+        
+        arr[j + 1] = key;
+    }
+    return true;
+}
+
+/**
+ * @brief Reverse arr[lo..hi]
+ */
+static void reverse_range(int arr[], int lo, int hi) {
+    while (lo < hi) {
+        swap_elements(arr, lo++, hi--);
+    }
+}
+
+/**
+ * @brief Natural merge sort: reverse the strictly descending runs, then
+ *        merge adjacent runs pairwise until one is left
+ *
+ * Time Complexity: O(n log r) for r runs
+ * Space Complexity: O(n + r)
+ * @param runs Number of runs found by probe_presortedness()
+ * @return false if the buffers could not be allocated (array unchanged)
+ */
+static bool run_merge_sort(int arr[], int size, int runs) {
+    int* bounds = malloc(((size_t)runs + 1) * sizeof(int));
+    int* scratch = malloc((size_t)size * sizeof(int));
+    if (bounds == NULL || scratch == NULL) {
+        free(bounds);
+        free(scratch);
+        return false;
+    }
+    
+    // Same scan as the probe, so exactly `runs` runs are found
+    int count = 0;
+    for (int i = 0; i < size; ) {
+        int j = i + 1;
+        bounds[count++] = i;
+        if (j < size && arr[j] < arr[i]) {
+            while (j < size && arr[j] < arr[j - 1]) {
+                j++;
+            }
+            reverse_range(arr, i, j - 1);
+        } else {
+            while (j < size && arr[j] >= arr[j - 1]) {
+                j++;
+            }
+        }
+        i = j;
+    }
+    bounds[count] = size;
+    
+    int* src = arr;
+    int* dst = scratch;
+    
+    while (count > 1) {
+        int merged = 0;
+        for (int r = 0; r < count; r += 2) {
+            int lo = bounds[r];
+            int mid = bounds[r + 1];
+            int hi = r + 2 <= count ? bounds[r + 2] : mid; // odd run out: copied
+            merge_runs(src, dst, lo, mid, hi);
+            bounds[merged++] = lo;
+        }
+        bounds[merged] = size;
+        count = merged;
+        
+        int* temp = src;
+        src = dst;
+        dst = temp;
+        
+        SORT_TRACE_ARRAY(src, size, "After run merge pass (%d runs left): ", count);
+    }
+    
+    if (src != arr) {
+        memcpy(arr, src, (size_t)size * sizeof(int));
+    }
+    free(bounds);
+    free(scratch);
+    return true;
+}
+
+/**
+ * @brief Counting sort over the key range [min_value, max_value]
+ * @return false if the histogram could not be allocated (array unchanged)
+ */
+static bool counting_sort(int arr[], int size, int min_value, int max_value) {
+    size_t range = (size_t)((long long)max_value - min_value + 1);
+    int* counts = calloc(range, sizeof(int));
+    if (counts == NULL) {
+        return false;
+    }
+    
+    for (int i = 0; i < size; i++) {
+        counts[(long long)arr[i] - min_value]++;
+    }
+    
+    int k = 0;
+    for (size_t v = 0; v < range; v++) {
+        int value = (int)((long long)min_value + (long long)v);
+        for (int c = counts[v]; c > 0; c--) {
+            arr[k++] = value;
+        }
+    }
+    SORT_COUNT_PERMUTATIONS(size);
+    
+    free(counts);
+    return true;
+}
+
+/**
+ * @brief Name of a sort engine
+ */
+const char* sort_engine_name(SortEngine engine) {
+    switch (engine) {
+        case SORT_ENGINE_NONE:
+            return "none";
+        case SORT_ENGINE_INSERTION:
+            return "insertion";
+        case SORT_ENGINE_RUN_MERGE:
+            return "run merge";
+        case SORT_ENGINE_COUNTING:
+            return "counting";
+        case SORT_ENGINE_RADIX:
+            return "radix";
+        case SORT_ENGINE_INTROSORT:
+            return "introsort";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Adaptive sort: probe the input, then run the engine that suits it
+ *
+ * Already sorted input is left alone; small inputs and nearly sorted ones
+ * (few estimated inversions) use insertion sort, which falls back to
+ * introsort if the estimate was wrong and its move budget runs out; a few
+ * long runs are reversed where descending and merged; a key range no
+ * larger than the input (or a small range with many duplicates) is
+ * counting sorted; other large inputs are radix sorted and the rest go to
+ * introsort. The probe and the decision are reported as trace messages
+ * and returned in `probe`.
+ * Time Complexity: O(n) probe, then that of the chosen engine
+ * Space Complexity: that of the chosen engine
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param probe Receives the measurements and the decision (may be NULL)
+ * @return Engine that sorted the array
+ */
+SortEngine auto_sort(int arr[], int size, SortProbe* probe) {
+    SortProbe local;
+    if (probe == NULL) {
+        probe = &local;
+    }
+    
+    probe_presortedness(arr, size, probe);
+    probe->engine = choose_engine(probe);
+    
+    SORT_TRACE_MESSAGE("auto_sort: n=%d runs=%d (%d descending) ~%.0f inversions "
+                       "range [%d, %d] %.0f%% duplicates",
+                       size, probe->runs, probe->descending_runs, probe->estimated_inversions,
+                       probe->min_value, probe->max_value, probe->duplicate_ratio * 100.0);
+    SORT_TRACE_MESSAGE("auto_sort: %s (%s)", sort_engine_name(probe->engine), probe->reason);
+    
+    const char* failure = NULL;
+    switch (probe->engine) {
+        case SORT_ENGINE_NONE:
+            break;
+        case SORT_ENGINE_INSERTION:
+            if (size <= AUTO_SMALL_SIZE) {
+                insertion_sort_range(arr, 0, size - 1);
+            } else if (!insertion_sort_bounded(arr, size, (long long)AUTO_INSERTION_BUDGET * size)) {
+                failure = "insertion sort move budget exceeded";
+            }
+            break;
+        case SORT_ENGINE_RUN_MERGE:
+            if (!run_merge_sort(arr, size, probe->runs)) {
+                failure = "memory allocation failed";
+            }
+            break;
+        case SORT_ENGINE_COUNTING:
+            if (!counting_sort(arr, size, probe->min_value, probe->max_value)) {
+                failure = "memory allocation failed";
+            }
+            break;
+        case SORT_ENGINE_RADIX:
+            if (!radix_sort_int32((int32_t*)arr, (size_t)size, RADIX_DEFAULT_DIGIT_BITS)) {
+                failure = "memory allocation failed";
+            }
+            break;
+        case SORT_ENGINE_INTROSORT:
+            quick_sort(arr, 0, size - 1);
+            break;
+    }
+    
+    if (failure != NULL) {
+        SORT_TRACE_MESSAGE("auto_sort: %s, falling back to introsort", failure);
+        probe->engine = SORT_ENGINE_INTROSORT;
+        probe->reason = failure;
+        quick_sort(arr, 0, size - 1);
+    }
+    return probe->engine;
+}
+
+/* Selection: ranges at or below this size are finished with insertion sort */
+#define SELECT_INSERTION_THRESHOLD 16
+
+/**
+ * @brief Three-way partition of arr[low..high] around a value
+ * @param lt Receives the first index of the "== pivot" block
+ * @param gt Receives the last index of the "== pivot" block
+ */
+static void partition_three_way(int arr[], int low, int high, int pivot, int* lt, int* gt) {
+    int lo = low, i = low, hi = high;
+    
+    while (i <= hi) {
+        SORT_COUNT_COMPARISON();
+        if (arr[i] < pivot) {
+            swap_elements(arr, lo++, i++);
+        } else if (arr[i] > pivot) {
+            swap_elements(arr, i, hi--);
+        } else {
+            i++;
+        }
+    }
+    *lt = lo;
+    *gt = hi;
+}
+
+static void median_of_medians_select(int arr[], int low, int high, int k);
+
+/**
+ * @brief Median of the medians of groups of five, moved to the front of
+ *        arr[low..high]
+ * @return Index of the pivot
+ */
+static int median_of_medians(int arr[], int low, int high) {
+    int count = 0;
+    
+    for (int i = low; i <= high; i += 5) {
+        int end = i + 4 < high ? i + 4 : high;
+        insertion_sort_range(arr, i, end);
+        swap_elements(arr, low + count, i + (end - i) / 2);
+        count++;
+    }
+    
+    int mid = low + (count - 1) / 2;
+    median_of_medians_select(arr, low, low + count - 1, mid);
+    return mid;
+}
+
+/**
+ * @brief Deterministic selection (BFPRT): put the k-th smallest element
+ *        of arr[low..high] at index k in O(n) worst case
+ */
+static void median_of_medians_select(int arr[], int low, int high, int k) {
+    while (high - low + 1 > SELECT_INSERTION_THRESHOLD) {
+        int pivot = arr[median_of_medians(arr, low, high)];
+        int lt, gt;
+        
+        partition_three_way(arr, low, high, pivot, &lt, &gt);
+        if (k < lt) {
+            high = lt - 1;
+        } else if (k > gt) {
+            low = gt + 1;
+        } else {
+            return;
+        }
+    }
+    insertion_sort_range(arr, low, high);
+}
+
+/**
+ * @brief Select the k-th smallest element (introselect)
+ *
+ * Afterwards arr[k] holds the value it would hold if the array were
+ * sorted, no element before it is greater and no element after it is
+ * smaller. Quickselect steps use partition(); if 2*log2(n) of them have
+ * not finished the job, median-of-medians selection takes over.
+ * Time Complexity: O(n) average, O(n log n) worst case
+ * Space Complexity: O(log n)
+ * @param arr Array to partially order
+ * @param size Size of the array
+ * @param k Rank to select, in [0, size)
+ */
+void nth_element(int arr[], int size, int k) {
+    if (k < 0 || k >= size) {
+        return;
+    }
+    
+    int low = 0, high = size - 1;
+    int depth_limit = 2 * floor_log2(size);
+    
+    while (high - low + 1 > SELECT_INSERTION_THRESHOLD) {
+        if (depth_limit-- == 0) {
+            median_of_medians_select(arr, low, high, k);
+            SORT_TRACE_ARRAY(arr, size, "After median-of-medians selection [%d-%d]: ", low, high);
+            return;
+        }
+        
+        int pi = partition(arr, low, high);
+        SORT_TRACE_ARRAY(arr, size, "After partitioning (pivot at index %d): ", pi);
+        
+        if (pi == k) {
+            return;
+        }
+        if (k < pi) {
+            high = pi - 1;
+        } else {
+            low = pi + 1;
+        }
+    }
+    insertion_sort_range(arr, low, high);
+}
+
+/**
+ * @brief Sort the k smallest elements into arr[0..k)
+ *
+ * Selects the k-th smallest element with nth_element(), then sorts the
+ * part before it with pdq_sort(); the order of arr[k..size) is unspecified.
+ * Time Complexity: O(n + k log k) average
+ * Space Complexity: O(log n)
+ * @param arr Array to partially sort
+ * @param size Size of the array
+ * @param k Number of smallest elements wanted (clamped to size)
+ */
+void partial_sort(int arr[], int size, int k) {
+    if (k > size) {
+        k = size;
+    }
+    if (k <= 0) {
+        return;
+    }
+    if (k == size) {
+        pdq_sort(arr, size);
+        return;
+    }
+    nth_element(arr, size, k - 1);
+    pdq_sort(arr, k - 1);
+}
+
+/**
+ * @brief Restore the min-heap property below a node
+ */
+static void sift_down_min(int heap[], int root, int size) {
+    int value = heap[root];
+    
+    while (2 * root + 1 < size) {
+        int child = 2 * root + 1;
+        if (child + 1 < size && heap[child + 1] < heap[child]) {
+            child++;
+        }
+        SORT_COUNT_COMPARISONS(2);
+        if (value <= heap[child]) {
+            break;
+        }
+        heap[root] = heap[child];
+        root = child;
+    }
+    
+    heap[root] = value;
+}
+
+/**
+ * @brief Start collecting the k largest values of a stream
+ * @param top Collector to initialize
+ * @param storage Caller-provided buffer of at least k elements
+ * @param k Number of values to keep (>= 0)
+ */
+void top_k_init(TopK* top, int storage[], int k) {
+    top->values = storage;
+    top->capacity = k;
+    top->count = 0;
+}
+
+/**
+ * @brief Offer a value to the collector
+ *
+ * The values are kept in a min-heap, so a value that does not beat the
+ * smallest one kept costs a single comparison.
+ * Time Complexity: O(1) for rejected values, O(log k) otherwise
+ * @param top Collector
+ * @param value Value from the stream
+ */
+void top_k_push(TopK* top, int value) {
+    SORT_COUNT_COMPARISON();
+    if (top->count == top->capacity) {
+        if (top->count > 0 && value > top->values[0]) {
+            top->values[0] = value;
+            sift_down_min(top->values, 0, top->count);
+            SORT_COUNT_PERMUTATION();
+        }
+        return;
+    }
+    
+    // Heap not full yet: sift the new value up
+    int i = top->count++;
+    while (i > 0 && value < top->values[(i - 1) / 2]) {
+        top->values[i] = top->values[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    top->values[i] = value;
+    SORT_COUNT_PERMUTATION();
+}
+
+/**
+ * @brief Sort the collected values in descending order (the collector
+ *        is left empty; the values stay in the storage buffer)
+ * Time Complexity: O(k log k)
+ * @param top Collector
+ * @return Number of values in the storage buffer
+ */
+int top_k_finish(TopK* top) {
+    int count = top->count;
+    
+    // Heap sort with a min-heap: each minimum moves to the end
+    for (int end = count - 1; end > 0; end--) {
+        swap_elements(top->values, 0, end);
+        sift_down_min(top->values, 0, end);
+    }
+    top->count = 0;
+    return count;
+}
+
+/**
+ * @brief The k largest values of an array, largest first
+ *
+ * Streams the array once through a bounded min-heap, so it works on data
+ * that is read once and never stored, and leaves the input untouched.
+ * Time Complexity: O(n log k) worst case, O(n + k log k log(n/k)) on random input
+ * Space Complexity: O(1) beyond the output buffer
+ * @param arr Values to scan
+ * @param size Number of values
+ * @param k Number of values wanted
+ * @param out Buffer of at least k elements receiving the result
+ * @return Number of values written (min(k, size))
+ */
+int top_k(const int arr[], int size, int k, int out[]) {
+    TopK top;
+    if (k > size) {
+        k = size;
+    }
+    top_k_init(&top, out, k > 0 ? k : 0);
+    
+    for (int i = 0; i < size; i++) {
+        top_k_push(&top, arr[i]);
     }
+    return top_k_finish(&top);
 }
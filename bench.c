@@ -0,0 +1,1173 @@
+/**
+ * @file bench.c
+ * @brief Non-interactive benchmark harness for the sorting algorithms
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Runs every array sorting algorithm over a set of sizes, input
+ * distributions and repetitions, and reports wall time, ns/element,
+ * median and p95 over runs as a table, CSV or JSON.
+ *
+ * The string-table (table_*) and linked-list (list_*) algorithms sort
+ * words derived from the same integer inputs: each value becomes seven
+ * letters in base 26 after an optional common prefix, so the word order
+ * matches the value order of every distribution.
+ *
+ * Usage: sorting_bench [options]
+ *   --sizes LIST        Comma-separated sizes (default 10,1000,100000,1000000)
+ *   --dists LIST        Comma-separated distributions (default: all)
+ *   --algos LIST        Comma-separated algorithm names (default: all)
+ *   --reps N            Repetitions per configuration (default 5)
+ *   --threads LIST      Thread counts for parallel algorithms
+ *                       (default: powers of two up to the processor count)
+ *   --quadratic-limit N Largest size run through O(n^2) algorithms (default 20000)
+ *   --seed N            Seed for the input generator (default 42)
+ *   --simd LEVEL        Cap the sorting network kernels at scalar, sse4.1 or avx2
+ *   --string-prefix S   Common prefix of the words given to string algorithms
+ *   --string-nesting D  Start each word with 0..D 'a's, so the words nest like
+ *                       deep paths (default 0)
+ *   --k N               Elements wanted by partial_sort and top_k (default 1000);
+ *                       nth_element always selects the median
+ *   --segments MIN,MAX  Segment lengths of the segmented_* entries (default 8,200)
+ *   --format FMT        table, csv or json (default table)
+ *   --perf              Add hardware counters per element (cycles, instructions,
+ *                       L1D/LLC misses, branch misses) to every result
+ *
+ * The comparison and permutation columns stay at zero unless the kernels
+ * are built with `make counters`. The bytes/elem column is the memory
+ * traffic of the merge passes (merge and multiway only, "-" otherwise).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sorting_algorithms.h"
+#include <errno.h>
+#include <limits.h>
+#include <stdint.h>
+
+/* Maximum number of entries accepted in a comma-separated option */
+#define BENCH_MAX_LIST 32
+
+/* Largest supported problem size */
+#define BENCH_MAX_SIZE 100000000L
+
+/* Letters encoding one value in a benchmark word (26^7 > 2^32) */
+#define BENCH_WORD_LETTERS 7
+
+/* Longest accepted --string-prefix */
+#define BENCH_MAX_PREFIX 200
+
+/* Largest accepted --string-nesting */
+#define BENCH_MAX_NESTING 10000
+
+typedef enum {
+    FORMAT_TABLE,
+    FORMAT_CSV,
+    FORMAT_JSON
+} OutputFormat;
+
+/**
+ * @brief Entry of the algorithm registry
+ */
+typedef struct {
+    const char* name;
+    void (*run)(int arr[], int size);
+    bool quadratic;     /* O(n^2): skipped above --quadratic-limit */
+    void (*run_threaded)(int arr[], int size, int threads);    /* parallel algorithms */
+    void (*run_table)(StringTable* table);                     /* string-table algorithms */
+    void (*run_list)(Node** head);                             /* linked-list algorithms */
+    bool (*check)(const int input[], const int output[], int size); /* NULL: sorted output */
+} BenchAlgorithm;
+
+/**
+ * @brief Word inputs of the string algorithms, built once per cell
+ */
+typedef struct {
+    StringTable table;
+    WordList list;
+    Node** nodes;       /* list nodes in input order */
+} StringInput;
+
+/**
+ * @brief Input distribution generator
+ */
+typedef struct {
+    const char* name;
+    void (*fill)(int arr[], int size);
+} BenchDistribution;
+
+/**
+ * @brief Aggregated timings of one (algorithm, distribution, size) cell
+ */
+typedef struct {
+    double min_ns;
+    double median_ns;
+    double p95_ns;
+    double total_ns;
+    unsigned long long comparisons;
+    unsigned long long permutations;
+    unsigned long long bytes_moved;             /* merge pass traffic of the last run */
+    double perf_per_element[PERF_EVENT_COUNT];  /* mean over runs, < 0 if unavailable */
+    bool sorted;
+} BenchResult;
+
+/* xorshift64* state for reproducible inputs */
+static uint64_t rng_state = 42;
+
+static uint64_t next_random(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+/* Elements wanted by the partial_sort and top_k entries (--k) */
+static int bench_k = 1000;
+
+/* Segments cut from each input by the segmented_* entries (--segments) */
+static long segment_min = 8;
+static long segment_max = 200;
+static size_t* segment_offsets;
+static size_t segment_count;
+
+/* Adapters giving every algorithm the (arr, size) shape */
+
+static void run_quick_sort(int arr[], int size) {
+    quick_sort(arr, 0, size - 1);
+}
+
+static void run_quick_sort_block(int arr[], int size) {
+    set_partition_scheme(PARTITION_BLOCK);
+    quick_sort(arr, 0, size - 1);
+    set_partition_scheme(PARTITION_LOMUTO);
+}
+
+static void run_merge_sort(int arr[], int size) {
+    merge_sort(arr, 0, size - 1);
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+static void run_generic_sort(int arr[], int size) {
+    generic_sort(arr, (size_t)size, sizeof(int), compare_ints);
+}
+
+static void run_libc_qsort(int arr[], int size) {
+    qsort(arr, (size_t)size, sizeof(int), compare_ints);
+}
+
+static void run_int32_quick_sort(int arr[], int size) {
+    int32_quick_sort((int32_t*)arr, (size_t)size);
+}
+
+static void run_multiway_merge_sort(int arr[], int size) {
+    multiway_merge_sort(arr, (size_t)size);
+}
+
+static void run_int32_merge_sort(int arr[], int size) {
+    int32_merge_sort((int32_t*)arr, (size_t)size);
+}
+
+static void run_radix8_sort(int arr[], int size) {
+    radix_sort_int32((int32_t*)arr, (size_t)size, 8);
+}
+
+static void run_radix16_sort(int arr[], int size) {
+    radix_sort_int32((int32_t*)arr, (size_t)size, 16);
+}
+
+static void run_auto_sort(int arr[], int size) {
+    auto_sort(arr, size, NULL);
+}
+
+/* Sort through argsort(): the indices gather the keys back into place */
+static void run_argsort_variant(int arr[], int size, bool stable) {
+    size_t* indices = malloc((size_t)size * sizeof(size_t));
+    int* keys = malloc((size_t)size * sizeof(int));
+    if (indices != NULL && keys != NULL && argsort(arr, (size_t)size, indices, stable)) {
+        for (int i = 0; i < size; i++) {
+            keys[i] = arr[indices[i]];
+        }
+        memcpy(arr, keys, (size_t)size * sizeof(int));
+    }
+    free(indices);
+    free(keys);
+}
+
+static void run_argsort(int arr[], int size) {
+    run_argsort_variant(arr, size, false);
+}
+
+static void run_argsort_stable(int arr[], int size) {
+    run_argsort_variant(arr, size, true);
+}
+
+static void run_nth_element(int arr[], int size) {
+    nth_element(arr, size, size / 2);
+}
+
+static void run_partial_sort(int arr[], int size) {
+    partial_sort(arr, size, bench_k);
+}
+
+static void run_top_k(int arr[], int size) {
+    // The result replaces the front of the array so it can be checked
+    int k = bench_k < size ? bench_k : size;
+    int* out = malloc((size_t)k * sizeof(int));
+    if (out != NULL) {
+        top_k(arr, size, k, out);
+        memcpy(arr, out, (size_t)k * sizeof(int));
+        free(out);
+    }
+}
+
+/* Read a sorted container back into the array, in order */
+static void copy_sorted_tree(const SortedTree* tree, int arr[]) {
+    SortedTreeCursor cursor;
+    int key;
+    sorted_tree_range(tree, INT_MIN, INT_MAX, &cursor);
+    while (sorted_tree_next(&cursor, &key)) {
+        *arr++ = key;
+    }
+}
+
+/* One insert per element: ns/elem is the cost of a streaming insert */
+static void run_sorted_tree_insert(int arr[], int size) {
+    SortedTree* tree = sorted_tree_create();
+    if (tree == NULL) {
+        return;
+    }
+    for (int i = 0; i < size; i++) {
+        if (!sorted_tree_insert(tree, arr[i])) {
+            sorted_tree_destroy(tree);
+            return;
+        }
+    }
+    copy_sorted_tree(tree, arr);
+    sorted_tree_destroy(tree);
+}
+
+/* Sort with radix sort, then build the container bottom-up */
+static void run_sorted_tree_bulk(int arr[], int size) {
+    SortedTree* tree = sorted_tree_create();
+    if (tree != NULL && radix_sort_int32((int32_t*)arr, (size_t)size, RADIX_DEFAULT_DIGIT_BITS) &&
+        sorted_tree_bulk_load(tree, arr, (size_t)size)) {
+        copy_sorted_tree(tree, arr);
+    }
+    sorted_tree_destroy(tree);
+}
+
+/* One call over every segment: kernels chosen per length, chunks on the pool */
+static void run_segmented_sort(int arr[], int size, int threads) {
+    (void)size;
+    segmented_sort(arr, segment_offsets, segment_count, threads);
+}
+
+/* Baselines: the existing functions called once per segment */
+static void run_segmented_insertion(int arr[], int size) {
+    (void)size;
+    for (size_t s = 0; s < segment_count; s++) {
+        insertion_sort(arr + segment_offsets[s], (int)(segment_offsets[s + 1] - segment_offsets[s]));
+    }
+}
+
+static void run_segmented_quick(int arr[], int size) {
+    (void)size;
+    for (size_t s = 0; s < segment_count; s++) {
+        quick_sort(arr + segment_offsets[s], 0, (int)(segment_offsets[s + 1] - segment_offsets[s]) - 1);
+    }
+}
+
+static void run_parallel_merge_sort(int arr[], int size, int threads) {
+    parallel_merge_sort(arr, (size_t)size, threads);
+}
+
+static void run_parallel_sample_sort(int arr[], int size, int threads) {
+    parallel_sample_sort(arr, (size_t)size, threads);
+}
+
+static void run_table_bubble(StringTable* table) {
+    bubble_sort_matrix(table);
+}
+
+static void run_table_merge(StringTable* table) {
+    merge_sort_matrix(table);
+}
+
+static void run_table_bubble_strcmp(StringTable* table) {
+    set_string_prefix_cache(false);
+    bubble_sort_matrix(table);
+    set_string_prefix_cache(true);
+}
+
+static void run_table_merge_strcmp(StringTable* table) {
+    set_string_prefix_cache(false);
+    merge_sort_matrix(table);
+    set_string_prefix_cache(true);
+}
+
+static void run_table_multikey(StringTable* table) {
+    multikey_sort_matrix(table);
+}
+
+static void run_table_msd(StringTable* table) {
+    msd_radix_sort_matrix(table);
+}
+
+static void run_list_bubble_strcmp(Node** head) {
+    set_string_prefix_cache(false);
+    bubble_sort_linked_list(head);
+    set_string_prefix_cache(true);
+}
+
+static void run_list_merge_strcmp(Node** head) {
+    set_string_prefix_cache(false);
+    merge_sort_linked_list(head);
+    set_string_prefix_cache(true);
+}
+
+static void run_list_multikey(Node** head) {
+    multikey_sort_linked_list(head);
+}
+
+static void run_list_msd(Node** head) {
+    msd_radix_sort_linked_list(head);
+}
+
+/* Checks of the selection entries, whose output is not fully sorted */
+
+static bool check_nth_element(const int input[], const int output[], int size) {
+    (void)input;
+    int k = size / 2;
+    for (int i = 0; i < size; i++) {
+        if ((i < k && output[i] > output[k]) || (i > k && output[i] < output[k])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_partial_sort(const int input[], const int output[], int size) {
+    (void)input;
+    int k = bench_k < size ? bench_k : size;
+    for (int i = 1; i < k; i++) {
+        if (output[i - 1] > output[i]) {
+            return false;
+        }
+    }
+    for (int i = k; i < size; i++) {
+        if (output[i] < output[k - 1]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_top_k(const int input[], const int output[], int size) {
+    int k = bench_k < size ? bench_k : size;
+    for (int i = 1; i < k; i++) {
+        if (output[i - 1] < output[i]) {
+            return false;
+        }
+    }
+    // Fewer than k inputs beat the smallest kept value, and enough tie it
+    int greater = 0, equal = 0;
+    for (int i = 0; i < size; i++) {
+        greater += input[i] > output[k - 1];
+        equal += input[i] == output[k - 1];
+    }
+    return greater < k && greater + equal >= k;
+}
+
+/* Every segment must be sorted; the array as a whole is not */
+static bool check_segments(const int input[], const int output[], int size) {
+    (void)input;
+    (void)size;
+    for (size_t s = 0; s < segment_count; s++) {
+        for (size_t i = segment_offsets[s] + 1; i < segment_offsets[s + 1]; i++) {
+            if (output[i - 1] > output[i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static const BenchAlgorithm algorithms[] = {
+    { "selection", selection_sort, true, NULL, NULL, NULL, NULL },
+    { "bubble", bubble_sort, true, NULL, NULL, NULL, NULL },
+    { "insertion", insertion_sort, true, NULL, NULL, NULL, NULL },
+    { "quick", run_quick_sort, false, NULL, NULL, NULL, NULL },
+    { "quick_block", run_quick_sort_block, false, NULL, NULL, NULL, NULL },
+    { "pdq", pdq_sort, false, NULL, NULL, NULL, NULL },
+    { "merge", run_merge_sort, false, NULL, NULL, NULL, NULL },
+    { "multiway", run_multiway_merge_sort, false, NULL, NULL, NULL, NULL },
+    { "comb", comb_sort, false, NULL, NULL, NULL, NULL },
+    { "heap", heap_sort, false, NULL, NULL, NULL, NULL },
+    { "radix", radix_sort, false, NULL, NULL, NULL, NULL },
+    { "radix8", run_radix8_sort, false, NULL, NULL, NULL, NULL },
+    { "radix16", run_radix16_sort, false, NULL, NULL, NULL, NULL },
+    { "generic", run_generic_sort, false, NULL, NULL, NULL, NULL },
+    { "qsort", run_libc_qsort, false, NULL, NULL, NULL, NULL },
+    { "int32_quick", run_int32_quick_sort, false, NULL, NULL, NULL, NULL },
+    { "int32_merge", run_int32_merge_sort, false, NULL, NULL, NULL, NULL },
+    { "auto", run_auto_sort, false, NULL, NULL, NULL, NULL },
+    { "argsort", run_argsort, false, NULL, NULL, NULL, NULL },
+    { "argsort_stable", run_argsort_stable, false, NULL, NULL, NULL, NULL },
+    { "nth_element", run_nth_element, false, NULL, NULL, NULL, check_nth_element },
+    { "partial_sort", run_partial_sort, false, NULL, NULL, NULL, check_partial_sort },
+    { "top_k", run_top_k, false, NULL, NULL, NULL, check_top_k },
+    { "btree", run_sorted_tree_insert, false, NULL, NULL, NULL, NULL },
+    { "btree_bulk", run_sorted_tree_bulk, false, NULL, NULL, NULL, NULL },
+    { "pmerge", NULL, false, run_parallel_merge_sort, NULL, NULL, NULL },
+    { "psample", NULL, false, run_parallel_sample_sort, NULL, NULL, NULL },
+    { "segmented", NULL, false, run_segmented_sort, NULL, NULL, check_segments },
+    { "segmented_insertion", run_segmented_insertion, false, NULL, NULL, NULL, check_segments },
+    { "segmented_quick", run_segmented_quick, false, NULL, NULL, NULL, check_segments },
+    { "table_bubble", NULL, true, NULL, run_table_bubble, NULL, NULL },
+    { "table_bubble_strcmp", NULL, true, NULL, run_table_bubble_strcmp, NULL, NULL },
+    { "table_merge", NULL, false, NULL, run_table_merge, NULL, NULL },
+    { "table_merge_strcmp", NULL, false, NULL, run_table_merge_strcmp, NULL, NULL },
+    { "table_multikey", NULL, false, NULL, run_table_multikey, NULL, NULL },
+    { "table_msd", NULL, false, NULL, run_table_msd, NULL, NULL },
+    { "list_bubble", NULL, true, NULL, NULL, bubble_sort_linked_list, NULL },
+    { "list_bubble_strcmp", NULL, true, NULL, NULL, run_list_bubble_strcmp, NULL },
+    { "list_merge", NULL, false, NULL, NULL, merge_sort_linked_list, NULL },
+    { "list_merge_strcmp", NULL, false, NULL, NULL, run_list_merge_strcmp, NULL },
+    { "list_merge_bounded", NULL, false, NULL, NULL, merge_sort_linked_list_bounded, NULL },
+    { "list_multikey", NULL, false, NULL, NULL, run_list_multikey, NULL },
+    { "list_msd", NULL, false, NULL, NULL, run_list_msd, NULL },
+};
+
+#define ALGORITHM_COUNT (sizeof(algorithms) / sizeof(algorithms[0]))
+
+/* Input distributions */
+
+static void fill_random(int arr[], int size) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = (int)(next_random() >> 33);
+    }
+}
+
+static void fill_sorted(int arr[], int size) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = i;
+    }
+}
+
+static void fill_reversed(int arr[], int size) {
+    for (int i = 0; i < size; i++) {
+        arr[i] = size - i;
+    }
+}
+
+static void fill_nearly_sorted(int arr[], int size) {
+    fill_sorted(arr, size);
+    // Swap about 1% of the elements with a random partner
+    for (int k = 0; k < size / 100 + 1; k++) {
+        int i = (int)(next_random() % (uint64_t)size);
+        int j = (int)(next_random() % (uint64_t)size);
+        int temp = arr[i];
+        arr[i] = arr[j];
+        arr[j] = temp;
+    }
+}
+
+static void fill_few_unique(int arr[], int size) {
+    // Same key range as generate_random_array() in the demo
+    for (int i = 0; i < size; i++) {
+        arr[i] = (int)(next_random() % 100);
+    }
+}
+
+static const BenchDistribution distributions[] = {
+    { "random", fill_random },
+    { "sorted", fill_sorted },
+    { "reversed", fill_reversed },
+    { "nearly_sorted", fill_nearly_sorted },
+    { "few_unique", fill_few_unique },
+};
+
+#define DISTRIBUTION_COUNT (sizeof(distributions) / sizeof(distributions[0]))
+
+/**
+ * @brief Current monotonic time in nanoseconds
+ */
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static bool is_sorted(const int arr[], int size) {
+    for (int i = 1; i < size; i++) {
+        if (arr[i - 1] > arr[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_table_sorted(const StringTable* table) {
+    for (size_t i = 1; i < table->rows; i++) {
+        if (strcmp(string_table_row(table, i - 1), string_table_row(table, i)) > 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool is_list_sorted(const Node* head, size_t count) {
+    size_t seen = 0;
+    for (const Node* current = head; current != NULL; current = current->next) {
+        if (current->next != NULL && strcmp(current->word, current->next->word) > 0) {
+            return false;
+        }
+        seen++;
+    }
+    return seen == count;
+}
+
+/**
+ * @brief Release the word inputs of the string algorithms
+ */
+static void free_string_input(StringInput* strings) {
+    string_table_free(&strings->table);
+    word_list_free(&strings->list);
+    free(strings->nodes);
+    strings->nodes = NULL;
+}
+
+/**
+ * @brief Number of 'a's that start the word of a value (0..nesting)
+ */
+static size_t word_nesting(int value, size_t nesting) {
+    return (size_t)(((uint32_t)value * 2654435761u) >> 8) % (nesting + 1);
+}
+
+/**
+ * @brief Build the words of the string algorithms from an integer input
+ *
+ * Every value becomes `prefix`, then a run of 0..nesting 'a's, then
+ * BENCH_WORD_LETTERS letters encoding it in base 26 (most significant
+ * first). Without nesting this preserves the order of the (non-negative)
+ * values; with it, words share prefixes of every length up to nesting.
+ * @return false if memory could not be allocated
+ */
+static bool build_string_input(StringInput* strings, const int input[], int size,
+                               const char* prefix, size_t nesting) {
+    size_t prefix_length = strlen(prefix);
+    char word[BENCH_MAX_PREFIX + BENCH_MAX_NESTING + BENCH_WORD_LETTERS + 1];
+    memcpy(word, prefix, prefix_length);
+
+    size_t bytes = (size_t)size * (prefix_length + BENCH_WORD_LETTERS + 1);
+    for (int i = 0; nesting > 0 && i < size; i++) {
+        bytes += word_nesting(input[i], nesting);
+    }
+
+    free_string_input(strings);
+    strings->nodes = malloc((size_t)size * sizeof(Node*));
+    if (strings->nodes == NULL || !string_table_reserve(&strings->table, (size_t)size, bytes)) {
+        return false;
+    }
+
+    for (int i = 0; i < size; i++) {
+        uint32_t value = (uint32_t)input[i];
+        size_t start = prefix_length + word_nesting(input[i], nesting);
+        memset(word + prefix_length, 'a', start - prefix_length);
+        for (int k = BENCH_WORD_LETTERS - 1; k >= 0; k--) {
+            word[start + (size_t)k] = (char)('a' + value % 26);
+            value /= 26;
+        }
+        size_t length = start + BENCH_WORD_LETTERS;
+        if (!string_table_append(&strings->table, word, length) ||
+            !word_list_append(&strings->list, word, length)) {
+            return false;
+        }
+        strings->nodes[i] = strings->list.tail;
+    }
+    return true;
+}
+
+/**
+ * @brief Restore the input order of the string table and word list
+ */
+static void reset_string_input(StringInput* strings, int size) {
+    for (size_t i = 0; i < strings->table.rows; i++) {
+        strings->table.order[i] = i;
+    }
+    for (int i = 0; i + 1 < size; i++) {
+        strings->nodes[i]->next = strings->nodes[i + 1];
+    }
+    strings->nodes[size - 1]->next = NULL;
+    strings->list.head = strings->nodes[0];
+    strings->list.tail = strings->nodes[size - 1];
+}
+
+/**
+ * @brief Value at the given percentile of an ascending sample
+ */
+static double percentile(const double sorted_samples[], int count, double pct) {
+    int index = (int)(pct / 100.0 * (count - 1) + 0.5);
+    return sorted_samples[index];
+}
+
+/**
+ * @brief Time one algorithm on one input, repeated reps times
+ * @param algorithm Algorithm to run
+ * @param input Reference input, copied before every run
+ * @param work Scratch array of the same size
+ * @param size Number of elements
+ * @param reps Number of repetitions
+ * @param threads Thread count passed to parallel algorithms
+ * @param strings Word inputs of the string algorithms
+ * @param samples Buffer of at least reps entries for the run times
+ * @param perf Hardware counters wrapped around every run, or NULL
+ * @return Aggregated result
+ */
+static BenchResult bench_one(const BenchAlgorithm* algorithm, const int input[], int work[],
+                             int size, int reps, int threads, StringInput* strings,
+                             double samples[], PerfCounters* perf) {
+    BenchResult result = { 0 };
+    uint64_t perf_totals[PERF_EVENT_COUNT] = { 0 };
+    result.sorted = true;
+
+    for (int r = 0; r < reps; r++) {
+        bool sorted;
+        if (algorithm->run_table != NULL || algorithm->run_list != NULL) {
+            reset_string_input(strings, size);
+        } else {
+            memcpy(work, input, (size_t)size * sizeof(int));
+        }
+        reset_counters();
+        if (perf != NULL) {
+            perf_counters_start(perf);
+        }
+
+        double start = now_ns();
+        if (algorithm->run_table != NULL) {
+            algorithm->run_table(&strings->table);
+        } else if (algorithm->run_list != NULL) {
+            algorithm->run_list(&strings->list.head);
+        } else if (algorithm->run_threaded != NULL) {
+            algorithm->run_threaded(work, size, threads);
+        } else {
+            algorithm->run(work, size);
+        }
+        samples[r] = now_ns() - start;
+        if (perf != NULL) {
+            perf_counters_stop(perf);
+            for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+                perf_totals[e] += perf->values[e];
+            }
+        }
+
+        if (algorithm->run_table != NULL) {
+            sorted = is_table_sorted(&strings->table);
+        } else if (algorithm->run_list != NULL) {
+            sorted = is_list_sorted(strings->list.head, (size_t)size);
+        } else if (algorithm->check != NULL) {
+            sorted = algorithm->check(input, work, size);
+        } else {
+            sorted = is_sorted(work, size);
+        }
+
+        result.total_ns += samples[r];
+        result.comparisons = comparison_count;
+        result.permutations = permutation_count;
+        result.bytes_moved = bytes_moved_count;
+        if (!sorted) {
+            result.sorted = false;
+        }
+    }
+
+    qsort(samples, (size_t)reps, sizeof(double), compare_doubles);
+    result.min_ns = samples[0];
+    result.median_ns = percentile(samples, reps, 50.0);
+    result.p95_ns = percentile(samples, reps, 95.0);
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        result.perf_per_element[e] = perf != NULL && perf_counter_available(perf, (PerfEvent)e)
+            ? (double)perf_totals[e] / ((double)reps * size)
+            : -1.0;
+    }
+    return result;
+}
+
+/**
+ * @brief Cut [0, size) into segments of random lengths in [segment_min, segment_max]
+ *
+ * The last segment is truncated to fit. segment_offsets must hold
+ * size / segment_min + 2 entries.
+ */
+static void build_segments(int size) {
+    size_t end = 0;
+    segment_count = 0;
+    segment_offsets[0] = 0;
+    while (end < (size_t)size) {
+        uint64_t span = (uint64_t)(segment_max - segment_min + 1);
+        size_t length = (size_t)segment_min + (size_t)(next_random() % span);
+        end = (length < (size_t)size - end) ? end + length : (size_t)size;
+        segment_offsets[++segment_count] = end;
+    }
+}
+
+/**
+ * @brief Split a comma-separated list in place
+ * @return Number of items, or -1 if there are too many
+ */
+static int split_list(char* list, char* items[], int max_items) {
+    int count = 0;
+    for (char* token = strtok(list, ","); token != NULL; token = strtok(NULL, ",")) {
+        if (count == max_items) {
+            return -1;
+        }
+        items[count++] = token;
+    }
+    return count;
+}
+
+static bool parse_long(const char* text, long min, long max, long* value) {
+    char* end;
+    errno = 0;
+    long parsed = strtol(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || parsed < min || parsed > max) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+static void print_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --sizes LIST        Comma-separated sizes, 10..%ld (default 10,1000,100000,1000000)\n"
+            "  --dists LIST        Distributions: random,sorted,reversed,nearly_sorted,few_unique\n"
+            "  --algos LIST        Algorithms: selection,bubble,insertion,quick,quick_block,\n"
+            "                      pdq,merge,multiway,comb,heap,radix,radix8,radix16,generic,qsort,\n"
+            "                      int32_quick,int32_merge,\n"
+            "                      auto,argsort,argsort_stable,nth_element,partial_sort,top_k,\n"
+            "                      btree,btree_bulk,\n"
+            "                      pmerge,psample,segmented,segmented_insertion,\n"
+            "                      segmented_quick,table_bubble,\n"
+            "                      table_bubble_strcmp,table_merge,table_merge_strcmp,\n"
+            "                      table_multikey,table_msd,list_bubble,list_bubble_strcmp,\n"
+            "                      list_merge,list_merge_strcmp,list_merge_bounded,list_multikey,\n"
+            "                      list_msd\n"
+            "  --reps N            Repetitions per configuration (default 5)\n"
+            "  --threads LIST      Thread counts for parallel algorithms (default 1,2,4,..,cpus)\n"
+            "  --quadratic-limit N Largest size for O(n^2) algorithms (default 20000)\n"
+            "  --seed N            Input generator seed (default 42)\n"
+            "  --simd LEVEL        Sorting network level: scalar, sse4.1 or avx2 (default: best)\n"
+            "  --string-prefix S   Common prefix of the words sorted by string algorithms\n"
+            "  --string-nesting D  Start each word with 0..D 'a's so words nest (default 0)\n"
+            "  --k N               Elements wanted by partial_sort and top_k (default 1000)\n"
+            "  --segments MIN,MAX  Segment lengths of the segmented_* entries (default 8,200)\n"
+            "  --format FMT        table, csv or json (default table)\n"
+            "  --perf              Report hardware counters per element (Linux perf_event_open)\n",
+            program, BENCH_MAX_SIZE);
+}
+
+/* Column names of the hardware counters (table, then CSV/JSON) */
+static const char* const perf_columns[PERF_EVENT_COUNT] = {
+    "cyc/elem", "ins/elem", "L1D/elem", "LLC/elem", "brmiss/elem"
+};
+static const char* const perf_keys[PERF_EVENT_COUNT] = {
+    "cycles_per_element", "instructions_per_element", "l1d_misses_per_element",
+    "llc_misses_per_element", "branch_misses_per_element"
+};
+
+static void print_header(OutputFormat format, bool perf) {
+    switch (format) {
+        case FORMAT_TABLE:
+            printf("%-20s %-14s %10s %7s %5s %12s %12s %12s %10s %14s %14s %10s %-*s",
+                   "algorithm", "distribution", "size", "threads", "runs", "min_ms", "median_ms",
+                   "p95_ms", "ns/elem", "comparisons", "permutations", "bytes/elem", perf ? 8 : 0,
+                   "status");
+            for (int e = 0; perf && e < PERF_EVENT_COUNT; e++) {
+                printf(" %11s", perf_columns[e]);
+            }
+            printf("\n");
+            break;
+        case FORMAT_CSV:
+            printf("algorithm,distribution,size,threads,runs,min_ms,median_ms,p95_ms,total_ms,"
+                   "ns_per_element,comparisons,permutations,bytes_per_element,sorted");
+            for (int e = 0; perf && e < PERF_EVENT_COUNT; e++) {
+                printf(",%s", perf_keys[e]);
+            }
+            printf("\n");
+            break;
+        case FORMAT_JSON:
+            printf("[\n");
+            break;
+    }
+}
+
+/**
+ * @brief Print the hardware counter columns of a result (unavailable
+ *        events print as n/a, an empty CSV field or null)
+ */
+static void print_perf_columns(OutputFormat format, const BenchResult* r) {
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        double value = r->perf_per_element[e];
+        switch (format) {
+            case FORMAT_TABLE:
+                if (value >= 0) {
+                    printf(" %11.3f", value);
+                } else {
+                    printf(" %11s", "n/a");
+                }
+                break;
+            case FORMAT_CSV:
+                if (value >= 0) {
+                    printf(",%.4f", value);
+                } else {
+                    printf(",");
+                }
+                break;
+            case FORMAT_JSON:
+                if (value >= 0) {
+                    printf(", \"%s\": %.4f", perf_keys[e], value);
+                } else {
+                    printf(", \"%s\": null", perf_keys[e]);
+                }
+                break;
+        }
+    }
+}
+
+static void print_result(OutputFormat format, bool first, const char* algorithm,
+                         const char* distribution, long size, int threads, int reps,
+                         const BenchResult* r, bool perf) {
+    double ns_per_element = r->median_ns / (double)size;
+    // Only algorithms that count their traffic report bytes per element
+    char bytes_per_element[32] = "";
+    if (r->bytes_moved > 0) {
+        snprintf(bytes_per_element, sizeof(bytes_per_element), "%.2f",
+                 (double)r->bytes_moved / (double)size);
+    }
+
+    switch (format) {
+        case FORMAT_TABLE:
+            printf("%-20s %-14s %10ld %7d %5d %12.3f %12.3f %12.3f %10.2f %14llu %14llu %10s %-*s",
+                   algorithm, distribution, size, threads, reps, r->min_ns / 1e6, r->median_ns / 1e6,
+                   r->p95_ns / 1e6, ns_per_element, r->comparisons, r->permutations,
+                   r->bytes_moved > 0 ? bytes_per_element : "-", perf ? 8 : 0,
+                   r->sorted ? "ok" : "UNSORTED");
+            break;
+        case FORMAT_CSV:
+            printf("%s,%s,%ld,%d,%d,%.6f,%.6f,%.6f,%.6f,%.4f,%llu,%llu,%s,%s",
+                   algorithm, distribution, size, threads, reps, r->min_ns / 1e6, r->median_ns / 1e6,
+                   r->p95_ns / 1e6, r->total_ns / 1e6, ns_per_element, r->comparisons,
+                   r->permutations, bytes_per_element, r->sorted ? "true" : "false");
+            break;
+        case FORMAT_JSON:
+            printf("%s  {\"algorithm\": \"%s\", \"distribution\": \"%s\", \"size\": %ld, "
+                   "\"threads\": %d, \"runs\": %d, \"min_ms\": %.6f, \"median_ms\": %.6f, \"p95_ms\": %.6f, "
+                   "\"total_ms\": %.6f, \"ns_per_element\": %.4f, \"comparisons\": %llu, "
+                   "\"permutations\": %llu, \"bytes_per_element\": %s, \"sorted\": %s",
+                   first ? "" : ",\n", algorithm, distribution, size, threads, reps, r->min_ns / 1e6,
+                   r->median_ns / 1e6, r->p95_ns / 1e6, r->total_ns / 1e6, ns_per_element,
+                   r->comparisons, r->permutations, r->bytes_moved > 0 ? bytes_per_element : "null",
+                   r->sorted ? "true" : "false");
+            break;
+    }
+    if (perf) {
+        print_perf_columns(format, r);
+    }
+    printf(format == FORMAT_JSON ? "}" : "\n");
+    fflush(stdout);
+}
+
+static void print_footer(OutputFormat format) {
+    if (format == FORMAT_JSON) {
+        printf("\n]\n");
+    }
+}
+
+/**
+ * @brief Main function of the benchmark harness
+ * @return Exit status (non-zero if an option is invalid or a run left
+ *         its output unsorted)
+ */
+int main(int argc, char* argv[]) {
+    char default_sizes[] = "10,1000,100000,1000000";
+    char* size_list = default_sizes;
+    char* dist_list = NULL;
+    char* algo_list = NULL;
+    char* thread_list = NULL;
+    long reps = 5;
+    long quadratic_limit = 20000;
+    long seed = 42;
+    const char* string_prefix_text = "";
+    long string_nesting = 0;
+    OutputFormat format = FORMAT_TABLE;
+    bool measure_perf = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool ok = value != NULL;
+
+        if (strcmp(option, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (strcmp(option, "--perf") == 0) {
+            measure_perf = true;
+            continue; // takes no value
+        } else if (ok && strcmp(option, "--sizes") == 0) {
+            size_list = argv[i + 1];
+        } else if (ok && strcmp(option, "--dists") == 0) {
+            dist_list = argv[i + 1];
+        } else if (ok && strcmp(option, "--algos") == 0) {
+            algo_list = argv[i + 1];
+        } else if (ok && strcmp(option, "--threads") == 0) {
+            thread_list = argv[i + 1];
+        } else if (ok && strcmp(option, "--reps") == 0) {
+            ok = parse_long(value, 1, 1000000, &reps);
+        } else if (ok && strcmp(option, "--quadratic-limit") == 0) {
+            ok = parse_long(value, 0, BENCH_MAX_SIZE, &quadratic_limit);
+        } else if (ok && strcmp(option, "--seed") == 0) {
+            ok = parse_long(value, 1, 0x7fffffffL, &seed);
+        } else if (ok && strcmp(option, "--simd") == 0) {
+            SimdLevel level = SIMD_LEVEL_AVX2;
+            while (strcmp(value, simd_level_name(level)) != 0 && level > SIMD_LEVEL_SCALAR) {
+                level--;
+            }
+            ok = strcmp(value, simd_level_name(level)) == 0;
+            if (ok && simd_set_level(level) != level) {
+                fprintf(stderr, "SIMD level %s is not supported by this CPU\n", value);
+                return 1;
+            }
+        } else if (ok && strcmp(option, "--k") == 0) {
+            long k;
+            ok = parse_long(value, 1, BENCH_MAX_SIZE, &k);
+            bench_k = (int)k;
+        } else if (ok && strcmp(option, "--segments") == 0) {
+            char* bounds[2];
+            ok = split_list(argv[i + 1], bounds, 2) == 2 &&
+                 parse_long(bounds[0], 1, BENCH_MAX_SIZE, &segment_min) &&
+                 parse_long(bounds[1], segment_min, BENCH_MAX_SIZE, &segment_max);
+        } else if (ok && strcmp(option, "--string-prefix") == 0) {
+            string_prefix_text = value;
+            ok = strlen(value) <= BENCH_MAX_PREFIX;
+        } else if (ok && strcmp(option, "--string-nesting") == 0) {
+            ok = parse_long(value, 0, BENCH_MAX_NESTING, &string_nesting);
+        } else if (ok && strcmp(option, "--format") == 0) {
+            if (strcmp(value, "table") == 0) {
+                format = FORMAT_TABLE;
+            } else if (strcmp(value, "csv") == 0) {
+                format = FORMAT_CSV;
+            } else if (strcmp(value, "json") == 0) {
+                format = FORMAT_JSON;
+            } else {
+                ok = false;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid option or value: %s\n", option);
+            print_usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    // Resolve the size list
+    char* items[BENCH_MAX_LIST];
+    long sizes[BENCH_MAX_LIST];
+    int size_count = split_list(size_list, items, BENCH_MAX_LIST);
+    if (size_count <= 0) {
+        fprintf(stderr, "Invalid size list\n");
+        return 1;
+    }
+    long max_size = 0;
+    for (int i = 0; i < size_count; i++) {
+        if (!parse_long(items[i], 10, BENCH_MAX_SIZE, &sizes[i])) {
+            fprintf(stderr, "Invalid size: %s (expected 10..%ld)\n", items[i], BENCH_MAX_SIZE);
+            return 1;
+        }
+        if (sizes[i] > max_size) {
+            max_size = sizes[i];
+        }
+    }
+
+    // Resolve the thread counts
+    long thread_counts[BENCH_MAX_LIST];
+    int thread_count = 0;
+    if (thread_list != NULL) {
+        thread_count = split_list(thread_list, items, BENCH_MAX_LIST);
+        if (thread_count <= 0) {
+            fprintf(stderr, "Invalid thread list\n");
+            return 1;
+        }
+        for (int i = 0; i < thread_count; i++) {
+            if (!parse_long(items[i], 1, 4096, &thread_counts[i])) {
+                fprintf(stderr, "Invalid thread count: %s\n", items[i]);
+                return 1;
+            }
+        }
+    } else {
+        int cpus = thread_pool_default_threads();
+        for (long t = 1; t < cpus && thread_count < BENCH_MAX_LIST - 1; t *= 2) {
+            thread_counts[thread_count++] = t;
+        }
+        thread_counts[thread_count++] = cpus;
+    }
+
+    // Resolve the algorithm and distribution selections
+    bool use_algorithm[ALGORITHM_COUNT];
+    bool use_distribution[DISTRIBUTION_COUNT];
+    for (size_t a = 0; a < ALGORITHM_COUNT; a++) {
+        use_algorithm[a] = (algo_list == NULL);
+    }
+    for (size_t d = 0; d < DISTRIBUTION_COUNT; d++) {
+        use_distribution[d] = (dist_list == NULL);
+    }
+
+    if (algo_list != NULL) {
+        int count = split_list(algo_list, items, BENCH_MAX_LIST);
+        for (int i = 0; i < count; i++) {
+            size_t a = 0;
+            while (a < ALGORITHM_COUNT && strcmp(items[i], algorithms[a].name) != 0) {
+                a++;
+            }
+            if (a == ALGORITHM_COUNT) {
+                fprintf(stderr, "Unknown algorithm: %s\n", items[i]);
+                return 1;
+            }
+            use_algorithm[a] = true;
+        }
+    }
+    if (dist_list != NULL) {
+        int count = split_list(dist_list, items, BENCH_MAX_LIST);
+        for (int i = 0; i < count; i++) {
+            size_t d = 0;
+            while (d < DISTRIBUTION_COUNT && strcmp(items[i], distributions[d].name) != 0) {
+                d++;
+            }
+            if (d == DISTRIBUTION_COUNT) {
+                fprintf(stderr, "Unknown distribution: %s\n", items[i]);
+                return 1;
+            }
+            use_distribution[d] = true;
+        }
+    }
+
+    bool use_strings = false;
+    bool use_segments = false;
+    for (size_t a = 0; a < ALGORITHM_COUNT; a++) {
+        if (use_algorithm[a] && (algorithms[a].run_table != NULL || algorithms[a].run_list != NULL)) {
+            use_strings = true;
+        }
+        if (use_algorithm[a] && algorithms[a].check == check_segments) {
+            use_segments = true;
+        }
+    }
+    StringInput strings;
+    string_table_init(&strings.table);
+    word_list_init(&strings.list);
+    strings.nodes = NULL;
+
+    int* input = malloc((size_t)max_size * sizeof(int));
+    int* work = malloc((size_t)max_size * sizeof(int));
+    double* samples = malloc((size_t)reps * sizeof(double));
+    if (use_segments) {
+        segment_offsets = malloc(((size_t)(max_size / segment_min) + 2) * sizeof(size_t));
+    }
+    if (input == NULL || work == NULL || samples == NULL || (use_segments && segment_offsets == NULL)) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        free(input);
+        free(work);
+        free(samples);
+        free(segment_offsets);
+        return 1;
+    }
+
+    // Kernels run silently: no observer is registered
+    set_sort_observer(NULL);
+    fprintf(stderr, "Sorting network level: %s\n", simd_level_name(simd_get_level()));
+    fprintf(stderr, "Operation counters: %s\n", SORT_COUNTERS_ENABLED ? "enabled" : "disabled");
+    CacheSizes caches;
+    bool caches_detected = detect_cache_sizes(&caches);
+    fprintf(stderr, "Caches: L1d %lu KiB, L2 %lu KiB, line %lu bytes%s\n",
+            (unsigned long)(caches.l1d / 1024), (unsigned long)(caches.l2 / 1024),
+            (unsigned long)caches.line, caches_detected ? "" : " (defaults)");
+
+    PerfCounters perf;
+    if (measure_perf && !perf_counters_open(&perf)) {
+        fprintf(stderr, "Hardware counters unavailable: %s\n", strerror(perf.error));
+    }
+
+    bool first = true;
+    bool all_sorted = true;
+    print_header(format, measure_perf);
+
+    for (size_t d = 0; d < DISTRIBUTION_COUNT; d++) {
+        if (!use_distribution[d]) {
+            continue;
+        }
+        for (int s = 0; s < size_count; s++) {
+            int size = (int)sizes[s];
+            rng_state = (uint64_t)seed * 0x9E3779B97F4A7C15ULL + (uint64_t)size;
+            distributions[d].fill(input, size);
+            if (use_strings && !build_string_input(&strings, input, size, string_prefix_text,
+                                                  (size_t)string_nesting)) {
+                fprintf(stderr, "Memory allocation failed for string inputs!\n");
+                if (measure_perf) {
+                    perf_counters_close(&perf);
+                }
+                free_string_input(&strings);
+                free(input);
+                free(work);
+                free(samples);
+                free(segment_offsets);
+                return 1;
+            }
+            if (use_segments) {
+                build_segments(size);
+            }
+
+            for (size_t a = 0; a < ALGORITHM_COUNT; a++) {
+                if (!use_algorithm[a] || (algorithms[a].quadratic && size > quadratic_limit)) {
+                    continue;
+                }
+                // Sequential algorithms run once; parallel ones once per thread count
+                int runs = algorithms[a].run_threaded != NULL ? thread_count : 1;
+                for (int t = 0; t < runs; t++) {
+                    int threads = algorithms[a].run_threaded != NULL ? (int)thread_counts[t] : 1;
+                    BenchResult result = bench_one(&algorithms[a], input, work, size,
+                                                   (int)reps, threads, &strings, samples,
+                                                   measure_perf ? &perf : NULL);
+                    print_result(format, first, algorithms[a].name, distributions[d].name,
+                                 size, threads, (int)reps, &result, measure_perf);
+                    first = false;
+                    all_sorted = all_sorted && result.sorted;
+                }
+            }
+        }
+    }
+
+    print_footer(format);
+    if (measure_perf) {
+        perf_counters_close(&perf);
+    }
+
+    free_string_input(&strings);
+    free(input);
+    free(work);
+    free(samples);
+    free(segment_offsets);
+    return all_sorted ? 0 : 1;
+}
@@ -0,0 +1,669 @@
+/**
+ * @file cli.c
+ * @brief Command-line mode: sort integers or words from a file or stdin
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Regular files are mapped with mmap(); pipes and terminals are read in
+ * large blocks. Text is parsed by hand (no scanf/strtol per token) and
+ * integers are written through a buffered two-digits-at-a-time formatter,
+ * so parsing and printing stay well below the sort time at 10^8 values.
+ *
+ * Usage: sorting_demo [options] [FILE]   (no FILE or "-": stdin; without
+ *        any argument the interactive demo starts, so use "-" to sort
+ *        stdin with the default options)
+ *   --words           Sort whitespace-separated words instead of integers
+ *   --in FMT          Integer input: text (default), int32 or int64
+ *                     (raw little-endian binary)
+ *   --out FMT         Integer output: text (default), int32 or int64
+ *   --output FILE     Write to FILE instead of stdout
+ *   --external        External merge sort (binary input, same --out width)
+ *   --memory SIZE     Memory budget of --external, suffix K, M or G
+ *   --temp-dir DIR    Directory for the runs of --external
+ *   --fan-in N        Runs merged per pass by --external
+ *   --timing          Report read, sort and write times on stderr
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sorting_algorithms.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Size of the output buffer */
+#define CLI_OUTPUT_BUFFER (1 << 16)
+
+/* Block size used when the input cannot be mapped */
+#define CLI_READ_BLOCK (1 << 20)
+
+/* Longest decimal representation of an int64_t, sign included */
+#define CLI_MAX_DIGITS 20
+
+typedef enum {
+    CLI_FORMAT_TEXT,
+    CLI_FORMAT_INT32,
+    CLI_FORMAT_INT64
+} CliFormat;
+
+/**
+ * @brief Whole input, mapped or read into memory
+ */
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    bool mapped;
+} CliInput;
+
+/**
+ * @brief Buffered writer
+ */
+typedef struct {
+    FILE* file;
+    char buffer[CLI_OUTPUT_BUFFER];
+    size_t used;
+    bool failed;
+    int error;      /* errno of the first failed write */
+} CliOutput;
+
+/* "00" "01" ... "99": the formatter emits two digits per division */
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static double cli_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static bool is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static bool is_little_endian(void) {
+    const uint16_t probe = 1;
+    return *(const unsigned char*)&probe == 1;
+}
+
+/**
+ * @brief Map a regular file, or read any other input to its end
+ * @param path File name, or NULL/"-" for stdin
+ * @return false on failure (a message is printed to stderr)
+ */
+static bool load_input(const char* path, CliInput* input) {
+    bool use_stdin = path == NULL || strcmp(path, "-") == 0;
+    int fd = use_stdin ? STDIN_FILENO : open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    input->data = NULL;
+    input->size = 0;
+    input->mapped = false;
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        void* map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            posix_madvise(map, (size_t)info.st_size, POSIX_MADV_SEQUENTIAL);
+            input->data = map;
+            input->size = (size_t)info.st_size;
+            input->mapped = true;
+            if (!use_stdin) {
+                close(fd);
+            }
+            return true;
+        }
+    }
+
+    // Not mappable (pipe, terminal, ...): read in large blocks
+    unsigned char* buffer = NULL;
+    size_t capacity = 0;
+    for (;;) {
+        if (capacity - input->size < CLI_READ_BLOCK) {
+            capacity = capacity > 0 ? 2 * capacity : 4 * CLI_READ_BLOCK;
+            unsigned char* grown = realloc(buffer, capacity);
+            if (grown == NULL) {
+                fprintf(stderr, "Memory allocation failed while reading input!\n");
+                free(buffer);
+                if (!use_stdin) {
+                    close(fd);
+                }
+                return false;
+            }
+            buffer = grown;
+        }
+        ssize_t got = read(fd, buffer + input->size, capacity - input->size);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got < 0) {
+            fprintf(stderr, "Read failed: %s\n", strerror(errno));
+            free(buffer);
+            if (!use_stdin) {
+                close(fd);
+            }
+            return false;
+        }
+        if (got == 0) {
+            break;
+        }
+        input->size += (size_t)got;
+    }
+
+    if (!use_stdin) {
+        close(fd);
+    }
+    input->data = buffer;
+    return true;
+}
+
+static void free_input(CliInput* input) {
+    if (input->mapped) {
+        munmap((void*)input->data, input->size);
+    } else {
+        free((void*)input->data);
+    }
+    input->data = NULL;
+    input->size = 0;
+}
+
+/**
+ * @brief Record a failed write; only the first error is kept
+ */
+static void output_failed(CliOutput* out) {
+    if (!out->failed) {
+        out->failed = true;
+        out->error = errno;
+    }
+}
+
+static void output_flush(CliOutput* out) {
+    if (out->used > 0 && fwrite(out->buffer, 1, out->used, out->file) != out->used) {
+        output_failed(out);
+    }
+    out->used = 0;
+}
+
+static void output_bytes(CliOutput* out, const void* bytes, size_t length) {
+    if (CLI_OUTPUT_BUFFER - out->used < length) {
+        output_flush(out);
+        if (length > CLI_OUTPUT_BUFFER) {
+            if (fwrite(bytes, 1, length, out->file) != length) {
+                output_failed(out);
+            }
+            return;
+        }
+    }
+    memcpy(out->buffer + out->used, bytes, length);
+    out->used += length;
+}
+
+/**
+ * @brief Append a decimal integer followed by a newline
+ */
+static void output_integer(CliOutput* out, int64_t value) {
+    if (CLI_OUTPUT_BUFFER - out->used < CLI_MAX_DIGITS + 1) {
+        output_flush(out);
+    }
+
+    char digits[CLI_MAX_DIGITS];
+    char* p = digits + CLI_MAX_DIGITS;
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+
+    while (magnitude >= 100) {
+        unsigned pair = (unsigned)(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (magnitude >= 10) {
+        unsigned pair = (unsigned)magnitude * 2;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    } else {
+        *--p = (char)('0' + magnitude);
+    }
+    if (value < 0) {
+        *--p = '-';
+    }
+
+    size_t length = (size_t)(digits + CLI_MAX_DIGITS - p);
+    memcpy(out->buffer + out->used, p, length);
+    out->buffer[out->used + length] = '\n';
+    out->used += length + 1;
+}
+
+/**
+ * @brief Parse whitespace-separated decimal integers
+ * @return false on a malformed or out-of-range token or allocation failure
+ */
+static bool parse_text_integers(const CliInput* input, int64_t** values, size_t* count) {
+    const unsigned char* p = input->data;
+    const unsigned char* end = p + input->size;
+    size_t capacity = 0;
+
+    *values = NULL;
+    *count = 0;
+
+    for (;;) {
+        while (p < end && is_space(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return true;
+        }
+
+        const unsigned char* start = p;
+        bool negative = *p == '-';
+        if (*p == '-' || *p == '+') {
+            p++;
+        }
+
+        uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+        uint64_t magnitude = 0;
+        const unsigned char* digits = p;
+        while (p < end && *p >= '0' && *p <= '9') {
+            unsigned digit = (unsigned)(*p - '0');
+            if (magnitude > (limit - digit) / 10) {
+                fprintf(stderr, "Integer out of range at byte %zu\n", (size_t)(start - input->data));
+                return false;
+            }
+            magnitude = magnitude * 10 + digit;
+            p++;
+        }
+        if (p == digits || (p < end && !is_space(*p))) {
+            fprintf(stderr, "Invalid integer at byte %zu\n", (size_t)(start - input->data));
+            return false;
+        }
+
+        if (*count == capacity) {
+            capacity = capacity > 0 ? 2 * capacity : 4096;
+            int64_t* grown = realloc(*values, capacity * sizeof(int64_t));
+            if (grown == NULL) {
+                fprintf(stderr, "Memory allocation failed while parsing input!\n");
+                return false;
+            }
+            *values = grown;
+        }
+        (*values)[(*count)++] = negative ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    }
+}
+
+/**
+ * @brief Decode raw little-endian integers of the given width
+ */
+static bool parse_binary_integers(const CliInput* input, size_t width, int64_t** values,
+                                  size_t* count) {
+    if (input->size % width != 0) {
+        fprintf(stderr, "Binary input size is not a multiple of %zu bytes\n", width);
+        return false;
+    }
+
+    *count = input->size / width;
+    *values = malloc((*count > 0 ? *count : 1) * sizeof(int64_t));
+    if (*values == NULL) {
+        fprintf(stderr, "Memory allocation failed while parsing input!\n");
+        return false;
+    }
+
+    const unsigned char* p = input->data;
+    for (size_t i = 0; i < *count; i++, p += width) {
+        uint64_t bits = 0;
+        for (size_t b = 0; b < width; b++) {
+            bits |= (uint64_t)p[b] << (8 * b);
+        }
+        // Sign-extend 32-bit values
+        (*values)[i] = width == 4 ? (int64_t)(int32_t)(uint32_t)bits : (int64_t)bits;
+    }
+    return true;
+}
+
+/**
+ * @brief Sort integers, narrowing to int32 when the range allows it
+ * @return true if the values were left narrowed to int32 (in place)
+ */
+static bool sort_integers(int64_t values[], size_t count) {
+    int64_t min = INT64_MAX;
+    int64_t max = INT64_MIN;
+    for (size_t i = 0; i < count; i++) {
+        min = values[i] < min ? values[i] : min;
+        max = values[i] > max ? values[i] : max;
+    }
+
+    if (count > 0 && min >= INT32_MIN && max <= INT32_MAX) {
+        // Half the memory traffic: compact in place (each write lands before its read)
+        int32_t* narrow = (int32_t*)values;
+        for (size_t i = 0; i < count; i++) {
+            narrow[i] = (int32_t)values[i];
+        }
+        if (!radix_sort_int32(narrow, count, RADIX_DEFAULT_DIGIT_BITS)) {
+            int32_quick_sort(narrow, count);
+        }
+        return true;
+    }
+
+    if (!radix_sort_int64(values, count, RADIX_DEFAULT_DIGIT_BITS)) {
+        int64_quick_sort(values, count);
+    }
+    return false;
+}
+
+static bool write_integers(CliOutput* out, const int64_t values[], size_t count, bool narrow,
+                           CliFormat format) {
+    const int32_t* narrow_values = (const int32_t*)values;
+
+    for (size_t i = 0; i < count && !out->failed; i++) {
+        int64_t value = narrow ? narrow_values[i] : values[i];
+
+        if (format == CLI_FORMAT_TEXT) {
+            output_integer(out, value);
+            continue;
+        }
+
+        if (format == CLI_FORMAT_INT32 && (value < INT32_MIN || value > INT32_MAX)) {
+            fprintf(stderr, "Value %lld does not fit in int32 output\n", (long long)value);
+            return false;
+        }
+        size_t width = format == CLI_FORMAT_INT32 ? 4 : 8;
+        unsigned char bytes[8];
+        for (size_t b = 0; b < width; b++) {
+            bytes[b] = (unsigned char)((uint64_t)value >> (8 * b));
+        }
+        output_bytes(out, bytes, width);
+    }
+    return true;
+}
+
+/**
+ * @brief Parse whitespace-separated words into a string table
+ */
+static bool parse_words(const CliInput* input, StringTable* table) {
+    const unsigned char* p = input->data;
+    const unsigned char* end = p + input->size;
+
+    // Words plus their terminators never exceed the input size + 1
+    if (!string_table_reserve(table, 0, input->size + 1)) {
+        fprintf(stderr, "Memory allocation failed while parsing input!\n");
+        return false;
+    }
+
+    for (;;) {
+        while (p < end && is_space(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return true;
+        }
+        const unsigned char* start = p;
+        while (p < end && !is_space(*p)) {
+            p++;
+        }
+        if (!string_table_append(table, (const char*)start, (size_t)(p - start))) {
+            fprintf(stderr, "Memory allocation failed while parsing input!\n");
+            return false;
+        }
+    }
+}
+
+static bool parse_format(const char* text, CliFormat* format) {
+    if (strcmp(text, "text") == 0) {
+        *format = CLI_FORMAT_TEXT;
+    } else if (strcmp(text, "int32") == 0) {
+        *format = CLI_FORMAT_INT32;
+    } else if (strcmp(text, "int64") == 0) {
+        *format = CLI_FORMAT_INT64;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parse a byte count with an optional K, M or G suffix
+ */
+static bool parse_size(const char* text, size_t* size) {
+    char* end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || end == text) {
+        return false;
+    }
+    switch (*end) {
+        case 'K': case 'k': value <<= 10; end++; break;
+        case 'M': case 'm': value <<= 20; end++; break;
+        case 'G': case 'g': value <<= 30; end++; break;
+        default: break;
+    }
+    if (*end != '\0' || value > SIZE_MAX) {
+        return false;
+    }
+    *size = (size_t)value;
+    return true;
+}
+
+static void print_cli_usage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options] [FILE]\n"
+            "Sorts FILE (or stdin) and writes the result to stdout.\n"
+            "Without arguments the interactive demo starts; pass - to sort stdin.\n"
+            "  --words          Sort whitespace-separated words instead of integers\n"
+            "  --in FMT         Integer input: text (default), int32 or int64 (little-endian)\n"
+            "  --out FMT        Integer output: text (default), int32 or int64\n"
+            "  --output FILE    Write to FILE instead of stdout\n"
+            "  --external       External merge sort of binary input (--in int32|int64)\n"
+            "  --memory SIZE    Memory budget of --external, e.g. 512M (default 256M)\n"
+            "  --temp-dir DIR   Directory for the runs of --external (default $TMPDIR or /tmp)\n"
+            "  --fan-in N       Runs merged per pass by --external (default 64)\n"
+            "  --timing         Report read, sort and write times on stderr\n",
+            program);
+}
+
+/**
+ * @brief External merge sort between binary streams
+ */
+static int run_external(const char* input_path, FILE* out, CliFormat in_format,
+                        CliFormat out_format, const ExternalSortOptions* options) {
+    if (in_format == CLI_FORMAT_TEXT || out_format != in_format) {
+        fprintf(stderr, "--external needs --in int32|int64 and the same --out format\n");
+        return 1;
+    }
+    if (!is_little_endian()) {
+        fprintf(stderr, "--external is only supported on little-endian hosts\n");
+        return 1;
+    }
+
+    FILE* in = stdin;
+    if (input_path != NULL && strcmp(input_path, "-") != 0) {
+        in = fopen(input_path, "rb");
+        if (in == NULL) {
+            fprintf(stderr, "Cannot open %s: %s\n", input_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    ExternalSortOptions settings = *options;
+    settings.element_size = in_format == CLI_FORMAT_INT32 ? 4 : 8;
+    bool ok = external_sort_stream(in, out, &settings);
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Entry point of the command-line mode
+ * @param argc Argument count (at least one argument after the program name)
+ * @param argv Arguments
+ * @return Exit status
+ */
+int run_cli(int argc, char* argv[]) {
+    const char* input_path = NULL;
+    const char* output_path = NULL;
+    bool words = false;
+    bool external = false;
+    bool timing = false;
+    CliFormat in_format = CLI_FORMAT_TEXT;
+    CliFormat out_format = CLI_FORMAT_TEXT;
+    ExternalSortOptions external_options;
+    external_sort_default_options(&external_options);
+
+    for (int i = 1; i < argc; i++) {
+        const char* option = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool ok = true;
+        bool takes_value = false;
+
+        if (strcmp(option, "--help") == 0) {
+            print_cli_usage(argv[0]);
+            return 0;
+        } else if (strcmp(option, "--words") == 0) {
+            words = true;
+        } else if (strcmp(option, "--external") == 0) {
+            external = true;
+        } else if (strcmp(option, "--timing") == 0) {
+            timing = true;
+        } else if (strcmp(option, "--in") == 0) {
+            takes_value = true;
+            ok = value != NULL && parse_format(value, &in_format);
+        } else if (strcmp(option, "--out") == 0) {
+            takes_value = true;
+            ok = value != NULL && parse_format(value, &out_format);
+        } else if (strcmp(option, "--output") == 0) {
+            takes_value = true;
+            output_path = value;
+            ok = value != NULL;
+        } else if (strcmp(option, "--memory") == 0) {
+            takes_value = true;
+            ok = value != NULL && parse_size(value, &external_options.memory_budget);
+        } else if (strcmp(option, "--temp-dir") == 0) {
+            takes_value = true;
+            external_options.temp_dir = value;
+            ok = value != NULL;
+        } else if (strcmp(option, "--fan-in") == 0) {
+            takes_value = true;
+            char* end = NULL;
+            errno = 0;
+            long fan_in = value != NULL ? strtol(value, &end, 10) : 0;
+            external_options.fan_in = (int)fan_in;
+            ok = value != NULL && errno == 0 && end != value && *end == '\0' &&
+                 fan_in >= 2 && fan_in <= 65536;
+        } else if (option[0] == '-' && option[1] != '\0') {
+            ok = false;
+        } else if (input_path == NULL) {
+            input_path = option;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            fprintf(stderr, "Invalid option or value: %s\n", option);
+            print_cli_usage(argv[0]);
+            return 1;
+        }
+        if (takes_value) {
+            i++;
+        }
+    }
+
+    if (words && (in_format != CLI_FORMAT_TEXT || out_format != CLI_FORMAT_TEXT || external)) {
+        fprintf(stderr, "--words only supports text input and output\n");
+        return 1;
+    }
+
+    FILE* out = stdout;
+    if (output_path != NULL) {
+        out = fopen(output_path, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "Cannot create %s: %s\n", output_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    int status;
+    if (external) {
+        status = run_external(input_path, out, in_format, out_format, &external_options);
+    } else {
+        double start = cli_now();
+        CliInput input;
+        status = load_input(input_path, &input) ? 0 : 1;
+
+        CliOutput* writer = status == 0 ? malloc(sizeof(CliOutput)) : NULL;
+        if (status == 0 && writer == NULL) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            status = 1;
+        }
+
+        if (status == 0) {
+            writer->file = out;
+            writer->used = 0;
+            writer->failed = false;
+            writer->error = 0;
+
+            double parsed, sorted;
+            size_t count = 0;
+            if (words) {
+                StringTable table;
+                string_table_init(&table);
+                status = parse_words(&input, &table) ? 0 : 1;
+                free_input(&input);
+                parsed = cli_now();
+                if (status == 0 && !msd_radix_sort_matrix(&table) && !multikey_sort_matrix(&table)) {
+                    fprintf(stderr, "Memory allocation failed while sorting!\n");
+                    status = 1;
+                }
+                sorted = cli_now();
+                for (size_t i = 0; status == 0 && i < table.rows && !writer->failed; i++) {
+                    const char* row = string_table_row(&table, i);
+                    output_bytes(writer, row, strlen(row));
+                    output_bytes(writer, "\n", 1);
+                }
+                count = table.rows;
+                string_table_free(&table);
+            } else {
+                int64_t* values = NULL;
+                bool parsed_ok = in_format == CLI_FORMAT_TEXT
+                    ? parse_text_integers(&input, &values, &count)
+                    : parse_binary_integers(&input, in_format == CLI_FORMAT_INT32 ? 4 : 8,
+                                            &values, &count);
+                free_input(&input);
+                parsed = cli_now();
+                status = parsed_ok ? 0 : 1;
+                bool narrow = status == 0 && sort_integers(values, count);
+                sorted = cli_now();
+                if (status == 0 && !write_integers(writer, values, count, narrow, out_format)) {
+                    status = 1;
+                }
+                free(values);
+            }
+
+            output_flush(writer);
+            if (fflush(out) != 0) {
+                output_failed(writer);
+            }
+            if (writer->failed) {
+                fprintf(stderr, "Write failed: %s\n", strerror(writer->error));
+                status = 1;
+            }
+            free(writer);
+
+            if (timing) {
+                double written = cli_now();
+                fprintf(stderr, "%zu %s: read %.3f s, sort %.3f s, write %.3f s\n", count,
+                        words ? "words" : "integers", parsed - start, sorted - parsed,
+                        written - sorted);
+            }
+        }
+    }
+
+    if (out != stdout && fclose(out) != 0) {
+        status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,463 @@
+/**
+ * @file external_sorting.c
+ * @brief External merge sort for integer datasets larger than memory
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * The input is a raw array of native-endian int32 or int64 values. It is
+ * read in chunks that fit the memory budget, each chunk is sorted with the
+ * in-memory radix sort and spilled to an anonymous temporary file (created
+ * with mkstemp() and unlinked at once, so nothing is left behind on
+ * failure). The runs are then merged fan_in at a time through a loser
+ * tree, in as many passes as needed, with one large sequential buffer per
+ * run and one for the output.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sorting_algorithms.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* Smallest I/O buffer per merge input; the fan-in is reduced to respect it */
+#define EXTERNAL_MIN_BUFFER (64 * 1024)
+
+/* Smallest accepted memory budget */
+#define EXTERNAL_MIN_BUDGET (4 * EXTERNAL_MIN_BUFFER)
+
+/* Default memory budget and fan-in */
+#define EXTERNAL_DEFAULT_BUDGET ((size_t)256 * 1024 * 1024)
+#define EXTERNAL_DEFAULT_FAN_IN 64
+
+/**
+ * @brief Sorted run stored in a temporary file
+ */
+typedef struct {
+    FILE* file;
+    size_t count;       /* number of elements */
+} ExternalRun;
+
+/**
+ * @brief Buffered sequential reader of one run during a merge
+ */
+typedef struct {
+    FILE* file;
+    unsigned char* buffer;
+    size_t capacity;    /* elements the buffer holds */
+    size_t available;   /* elements currently buffered */
+    size_t position;    /* next buffered element */
+    size_t remaining;   /* elements not yet consumed, buffered or not */
+    int64_t value;      /* current head of the run */
+} RunReader;
+
+/**
+ * @brief Growable list of runs
+ */
+typedef struct {
+    ExternalRun* runs;
+    size_t count;
+    size_t capacity;
+} RunList;
+
+static int64_t load_value(const unsigned char* p, size_t width) {
+    if (width == sizeof(int32_t)) {
+        int32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    int64_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static void store_value(unsigned char* p, size_t width, int64_t value) {
+    if (width == sizeof(int32_t)) {
+        int32_t narrow = (int32_t)value;
+        memcpy(p, &narrow, sizeof(narrow));
+    } else {
+        memcpy(p, &value, sizeof(value));
+    }
+}
+
+/**
+ * @brief Read up to count elements; a trailing partial element is an error
+ * @return Number of elements read, or (size_t)-1 on error
+ */
+static size_t read_elements(FILE* file, unsigned char* buffer, size_t count, size_t width) {
+    size_t bytes = fread(buffer, 1, count * width, file);
+    if (ferror(file)) {
+        fprintf(stderr, "External sort: read failed: %s\n", strerror(errno));
+        return (size_t)-1;
+    }
+    if (bytes % width != 0) {
+        fprintf(stderr, "External sort: input size is not a multiple of %zu bytes\n", width);
+        return (size_t)-1;
+    }
+    return bytes / width;
+}
+
+static bool write_elements(FILE* file, const unsigned char* buffer, size_t count, size_t width) {
+    if (fwrite(buffer, width, count, file) != count) {
+        fprintf(stderr, "External sort: write failed: %s\n", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sort a chunk with the in-memory engine
+ */
+static void sort_chunk(unsigned char* chunk, size_t count, size_t width) {
+    if (width == sizeof(int32_t)) {
+        if (!radix_sort_int32((int32_t*)chunk, count, RADIX_DEFAULT_DIGIT_BITS)) {
+            int32_quick_sort((int32_t*)chunk, count);
+        }
+    } else {
+        if (!radix_sort_int64((int64_t*)chunk, count, RADIX_DEFAULT_DIGIT_BITS)) {
+            int64_quick_sort((int64_t*)chunk, count);
+        }
+    }
+}
+
+/**
+ * @brief Create an anonymous temporary file in the given directory
+ */
+static FILE* create_temp_file(const char* directory) {
+    size_t length = strlen(directory) + sizeof("/sortrun.XXXXXX");
+    char* path = malloc(length);
+    if (path == NULL) {
+        return NULL;
+    }
+    snprintf(path, length, "%s/sortrun.XXXXXX", directory);
+
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "External sort: cannot create a file in %s: %s\n", directory,
+                strerror(errno));
+        free(path);
+        return NULL;
+    }
+    unlink(path);
+    free(path);
+
+    FILE* file = fdopen(fd, "w+b");
+    if (file == NULL) {
+        close(fd);
+    }
+    return file;
+}
+
+static bool run_list_push(RunList* list, FILE* file, size_t count) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity > 0 ? 2 * list->capacity : 16;
+        ExternalRun* runs = realloc(list->runs, capacity * sizeof(ExternalRun));
+        if (runs == NULL) {
+            return false;
+        }
+        list->runs = runs;
+        list->capacity = capacity;
+    }
+    list->runs[list->count].file = file;
+    list->runs[list->count].count = count;
+    list->count++;
+    return true;
+}
+
+static void run_list_free(RunList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        fclose(list->runs[i].file);
+    }
+    free(list->runs);
+    list->runs = NULL;
+    list->count = 0;
+    list->capacity = 0;
+}
+
+/**
+ * @brief Load the next head of a run; returns false once it is exhausted
+ */
+static bool reader_advance(RunReader* reader, size_t width) {
+    if (reader->remaining == 0) {
+        return false;
+    }
+    if (reader->position == reader->available) {
+        size_t want = reader->remaining < reader->capacity ? reader->remaining : reader->capacity;
+        size_t got = read_elements(reader->file, reader->buffer, want, width);
+        if (got == (size_t)-1 || got == 0) {
+            reader->remaining = 0;
+            return false;
+        }
+        reader->available = got;
+        reader->position = 0;
+    }
+    reader->value = load_value(reader->buffer + reader->position * width, width);
+    reader->position++;
+    reader->remaining--;
+    return true;
+}
+
+/**
+ * @brief Loser tree over k runs
+ *
+ * tree[1..k) holds the loser of each internal match and tree[0] the
+ * overall winner; leaf i sits at virtual node k + i. Index k is a
+ * sentinel that beats everything and only exists while the tree is built.
+ * Exhausted runs lose every match.
+ */
+typedef struct {
+    size_t* tree;
+    bool* exhausted;
+    RunReader* readers;
+    size_t k;
+} LoserTree;
+
+static bool loser_tree_beats(const LoserTree* lt, size_t a, size_t b) {
+    if (a == lt->k) {
+        return true;
+    }
+    if (b == lt->k) {
+        return false;
+    }
+    if (lt->exhausted[a] || lt->exhausted[b]) {
+        return !lt->exhausted[a];
+    }
+    int64_t x = lt->readers[a].value;
+    int64_t y = lt->readers[b].value;
+    return x < y || (x == y && a < b);
+}
+
+/**
+ * @brief Replay the matches from leaf s up to the root
+ */
+static void loser_tree_adjust(LoserTree* lt, size_t s) {
+    for (size_t t = (s + lt->k) / 2; t > 0; t /= 2) {
+        if (loser_tree_beats(lt, lt->tree[t], s)) {
+            size_t temp = lt->tree[t];
+            lt->tree[t] = s;
+            s = temp;
+        }
+    }
+    lt->tree[0] = s;
+}
+
+/**
+ * @brief k-way merge of runs into an output stream
+ * @param runs Runs to merge (rewound by this call)
+ * @param k Number of runs
+ * @param out Output stream
+ * @param width Element size in bytes
+ * @param budget Bytes available for the k input buffers and the output buffer
+ * @return false on allocation or I/O failure
+ */
+static bool merge_runs_to(ExternalRun runs[], size_t k, FILE* out, size_t width, size_t budget) {
+    size_t buffer_elements = budget / (k + 1) / width;
+    unsigned char* memory = malloc((k + 1) * buffer_elements * width);
+    RunReader* readers = calloc(k, sizeof(RunReader));
+    size_t* tree = malloc((k + 1) * sizeof(size_t));
+    bool* exhausted = calloc(k, sizeof(bool));
+    bool ok = memory != NULL && readers != NULL && tree != NULL && exhausted != NULL;
+
+    if (ok) {
+        LoserTree lt = { tree, exhausted, readers, k };
+        unsigned char* output = memory + k * buffer_elements * width;
+        size_t pending = 0;
+
+        for (size_t i = 0; i < k; i++) {
+            readers[i].file = runs[i].file;
+            readers[i].buffer = memory + i * buffer_elements * width;
+            readers[i].capacity = buffer_elements;
+            readers[i].remaining = runs[i].count;
+            rewind(runs[i].file);
+#if defined(POSIX_FADV_SEQUENTIAL)
+            posix_fadvise(fileno(runs[i].file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            exhausted[i] = !reader_advance(&readers[i], width);
+        }
+
+        for (size_t i = 0; i <= k; i++) {
+            tree[i] = k;
+        }
+        for (size_t i = k; i > 0; i--) {
+            loser_tree_adjust(&lt, i - 1);
+        }
+
+        while (ok && !exhausted[tree[0]]) {
+            size_t winner = tree[0];
+            store_value(output + pending * width, width, readers[winner].value);
+            if (++pending == buffer_elements) {
+                ok = write_elements(out, output, pending, width);
+                pending = 0;
+            }
+            exhausted[winner] = !reader_advance(&readers[winner], width);
+            loser_tree_adjust(&lt, winner);
+        }
+
+        if (ok) {
+            ok = write_elements(out, output, pending, width);
+        }
+        for (size_t i = 0; ok && i < k; i++) {
+            if (readers[i].remaining != 0 || ferror(runs[i].file)) {
+                ok = false;
+            }
+        }
+    } else {
+        fprintf(stderr, "External sort: memory allocation failed for the merge\n");
+    }
+
+    free(memory);
+    free(readers);
+    free(tree);
+    free(exhausted);
+    return ok;
+}
+
+/**
+ * @brief Fill options with the defaults: 256 MiB budget, $TMPDIR (or /tmp),
+ *        fan-in 64, int32 elements
+ * @param options Options to fill
+ */
+void external_sort_default_options(ExternalSortOptions* options) {
+    const char* temp_dir = getenv("TMPDIR");
+
+    options->memory_budget = EXTERNAL_DEFAULT_BUDGET;
+    options->temp_dir = (temp_dir != NULL && temp_dir[0] != '\0') ? temp_dir : "/tmp";
+    options->fan_in = EXTERNAL_DEFAULT_FAN_IN;
+    options->element_size = sizeof(int32_t);
+}
+
+/**
+ * @brief External merge sort of a stream of raw native-endian integers
+ *
+ * Input that fits in one chunk is sorted in memory and written directly;
+ * otherwise sorted runs are spilled to temporary files and merged with a
+ * loser tree, fan_in runs per pass.
+ * Time Complexity: O(n log n) comparisons, O(n · passes) I/O
+ * Space Complexity: memory_budget bytes of RAM, up to 2n elements on disk
+ * @param in Input stream (read to the end)
+ * @param out Output stream
+ * @param options Budget, temporary directory, fan-in and element size (4 or 8)
+ * @return false on invalid options, allocation or I/O failure (a message
+ *         is printed to stderr)
+ */
+bool external_sort_stream(FILE* in, FILE* out, const ExternalSortOptions* options) {
+    size_t width = options->element_size;
+    if ((width != sizeof(int32_t) && width != sizeof(int64_t)) ||
+        options->memory_budget < EXTERNAL_MIN_BUDGET || options->fan_in < 2) {
+        fprintf(stderr, "External sort: invalid options (element size 4 or 8, "
+                "budget >= %d bytes, fan-in >= 2)\n", EXTERNAL_MIN_BUDGET);
+        return false;
+    }
+
+    // Half of the budget holds the chunk, the other half the radix scratch
+    size_t chunk_elements = options->memory_budget / 2 / width;
+    unsigned char* chunk = malloc(chunk_elements * width);
+    if (chunk == NULL) {
+        fprintf(stderr, "External sort: cannot allocate a %zu-byte chunk\n", chunk_elements * width);
+        return false;
+    }
+
+    RunList runs = { NULL, 0, 0 };
+    bool ok = true;
+
+    // Phase 1: sorted runs
+    for (;;) {
+        size_t count = read_elements(in, chunk, chunk_elements, width);
+        if (count == (size_t)-1) {
+            ok = false;
+            break;
+        }
+        if (count == 0) {
+            break;
+        }
+        sort_chunk(chunk, count, width);
+
+        if (runs.count == 0 && count < chunk_elements) {
+            // Everything fit in memory: no temporary file needed
+            ok = write_elements(out, chunk, count, width);
+            free(chunk);
+            return ok && fflush(out) == 0;
+        }
+
+        FILE* file = create_temp_file(options->temp_dir);
+        if (file == NULL || !write_elements(file, chunk, count, width) ||
+            !run_list_push(&runs, file, count)) {
+            if (file != NULL) {
+                fclose(file);
+            }
+            ok = false;
+            break;
+        }
+        SORT_TRACE_MESSAGE("Spilled run %zu (%zu elements)", runs.count, count);
+
+        if (count < chunk_elements) {
+            break;
+        }
+    }
+    free(chunk);
+
+    // Phase 2: merge passes until a single pass can produce the output
+    size_t fan_in = (size_t)options->fan_in;
+    size_t max_fan_in = options->memory_budget / EXTERNAL_MIN_BUFFER - 1;
+    if (fan_in > max_fan_in) {
+        fan_in = max_fan_in;
+    }
+
+    while (ok && runs.count > fan_in) {
+        RunList merged = { NULL, 0, 0 };
+        for (size_t first = 0; ok && first < runs.count; first += fan_in) {
+            size_t k = runs.count - first < fan_in ? runs.count - first : fan_in;
+            size_t total = 0;
+            for (size_t i = 0; i < k; i++) {
+                total += runs.runs[first + i].count;
+            }
+
+            FILE* file = create_temp_file(options->temp_dir);
+            ok = file != NULL && merge_runs_to(runs.runs + first, k, file, width,
+                                               options->memory_budget) &&
+                 fflush(file) == 0 && run_list_push(&merged, file, total);
+            if (!ok && file != NULL) {
+                fclose(file);
+            }
+        }
+        SORT_TRACE_MESSAGE("Merge pass: %zu runs -> %zu runs", runs.count, merged.count);
+        run_list_free(&runs);
+        runs = merged;
+    }
+
+    if (ok && runs.count > 0) {
+        ok = merge_runs_to(runs.runs, runs.count, out, width, options->memory_budget);
+    }
+    run_list_free(&runs);
+
+    return ok && fflush(out) == 0;
+}
+
+/**
+ * @brief External merge sort of a file of raw native-endian integers
+ * @param input_path File to sort
+ * @param output_path Destination (may not be the input file)
+ * @param options Budget, temporary directory, fan-in and element size
+ * @return false on failure (a message is printed to stderr)
+ */
+bool external_sort_file(const char* input_path, const char* output_path,
+                        const ExternalSortOptions* options) {
+    FILE* in = fopen(input_path, "rb");
+    if (in == NULL) {
+        fprintf(stderr, "External sort: cannot open %s: %s\n", input_path, strerror(errno));
+        return false;
+    }
+    FILE* out = fopen(output_path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "External sort: cannot create %s: %s\n", output_path, strerror(errno));
+        fclose(in);
+        return false;
+    }
+
+    bool ok = external_sort_stream(in, out, options);
+    fclose(in);
+    if (fclose(out) != 0) {
+        ok = false;
+    }
+    return ok;
+}
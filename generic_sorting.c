@@ -0,0 +1,164 @@
+/**
+ * @file generic_sorting.c
+ * @brief Type-generic sorting: qsort-compatible entry point and
+ *        specialized kernels for fixed-width numeric types
+ * @author Professional C Developer
+ * @date 2024
+ */
+
+#include "sorting_algorithms.h"
+
+/* Specialized kernel families declared in sorting_algorithms.h */
+SORT_DEFINE_SCOPED(, int32, int32_t, SORT_LESS_NUMERIC)
+SORT_DEFINE_SCOPED(, int64, int64_t, SORT_LESS_NUMERIC)
+SORT_DEFINE_SCOPED(, uint64, uint64_t, SORT_LESS_NUMERIC)
+SORT_DEFINE_SCOPED(, float, float, SORT_LESS_FLOATING)
+SORT_DEFINE_SCOPED(, double, double, SORT_LESS_FLOATING)
+
+/* Elements are swapped through a stack buffer of this many bytes at a time */
+#define SWAP_CHUNK 64
+
+/**
+ * @brief Swap two elements of the given size
+ */
+static void swap_bytes(unsigned char* a, unsigned char* b, size_t size) {
+    unsigned char chunk[SWAP_CHUNK];
+
+    while (size > 0) {
+        size_t n = size < SWAP_CHUNK ? size : SWAP_CHUNK;
+        memcpy(chunk, a, n);
+        memcpy(a, b, n);
+        memcpy(b, chunk, n);
+        a += n;
+        b += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief Insertion sort of elements [lo, hi) by adjacent swaps
+ */
+static void generic_insertion_range(unsigned char* base, size_t lo, size_t hi, size_t size,
+                                    int (*compare)(const void*, const void*)) {
+    for (size_t i = lo + 1; i < hi; i++) {
+        for (size_t j = i; j > lo && compare(base + (j - 1) * size, base + j * size) > 0; j--) {
+            swap_bytes(base + (j - 1) * size, base + j * size, size);
+        }
+    }
+}
+
+/**
+ * @brief Restore the max-heap property below a node
+ */
+static void generic_sift_down(unsigned char* base, size_t root, size_t count, size_t size,
+                              int (*compare)(const void*, const void*)) {
+    while (2 * root + 1 < count) {
+        size_t child = 2 * root + 1;
+        if (child + 1 < count && compare(base + child * size, base + (child + 1) * size) < 0) {
+            child++;
+        }
+        if (compare(base + root * size, base + child * size) >= 0) {
+            return;
+        }
+        swap_bytes(base + root * size, base + child * size, size);
+        root = child;
+    }
+}
+
+/**
+ * @brief Heap sort of count elements
+ */
+static void generic_heap_sort(unsigned char* base, size_t count, size_t size,
+                              int (*compare)(const void*, const void*)) {
+    for (size_t i = count / 2; i > 0; i--) {
+        generic_sift_down(base, i - 1, count, size, compare);
+    }
+    for (size_t end = count; end > 1; end--) {
+        swap_bytes(base, base + (end - 1) * size, size);
+        generic_sift_down(base, 0, end - 1, size, compare);
+    }
+}
+
+/**
+ * @brief Hoare partition of [lo, hi) around a median-of-three pivot
+ * @return Split point: [lo, cut) <= pivot <= [cut, hi), both non-empty
+ */
+static size_t generic_partition(unsigned char* base, size_t lo, size_t hi, size_t size,
+                                int (*compare)(const void*, const void*)) {
+    unsigned char* first = base + lo * size;
+    unsigned char* middle = base + (lo + (hi - lo) / 2) * size;
+    unsigned char* last = base + (hi - 1) * size;
+
+    // Order first <= middle <= last, then park the pivot at lo + 1
+    if (compare(middle, first) < 0) swap_bytes(middle, first, size);
+    if (compare(last, middle) < 0) swap_bytes(last, middle, size);
+    if (compare(middle, first) < 0) swap_bytes(middle, first, size);
+    swap_bytes(middle, base + (lo + 1) * size, size);
+
+    unsigned char* pivot = base + (lo + 1) * size;
+    size_t i = lo + 1;
+    size_t j = hi - 1;
+
+    for (;;) {
+        do { i++; } while (compare(base + i * size, pivot) < 0);
+        do { j--; } while (compare(pivot, base + j * size) < 0);
+        if (i >= j) {
+            break;
+        }
+        swap_bytes(base + i * size, base + j * size, size);
+    }
+
+    // Move the pivot to its final position
+    swap_bytes(pivot, base + j * size, size);
+    return j + 1;
+}
+
+static void generic_introsort_loop(unsigned char* base, size_t lo, size_t hi, int depth,
+                                   size_t size, int (*compare)(const void*, const void*)) {
+    while (hi - lo > SORT_GENERIC_INSERTION_THRESHOLD) {
+        if (depth == 0) {
+            generic_heap_sort(base + lo * size, hi - lo, size, compare);
+            return;
+        }
+        depth--;
+
+        size_t cut = generic_partition(base, lo, hi, size, compare);
+        if (cut - lo < hi - cut) {
+            generic_introsort_loop(base, lo, cut, depth, size, compare);
+            lo = cut;
+        } else {
+            generic_introsort_loop(base, cut, hi, depth, size, compare);
+            hi = cut;
+        }
+    }
+
+    generic_insertion_range(base, lo, hi, size, compare);
+}
+
+/**
+ * @brief qsort-compatible generic sort (introsort)
+ *
+ * Sorts count elements of size bytes each with the given comparator.
+ * Not stable. Use the specialized kernels (int64_quick_sort(), ...) or
+ * SORT_DEFINE() when the element type is known at compile time: they
+ * inline the comparison instead of calling through a function pointer.
+ * Time Complexity: O(n log n) worst case
+ * Space Complexity: O(log n)
+ * @param base Start of the array
+ * @param count Number of elements
+ * @param size Size of one element in bytes
+ * @param compare Comparator returning <0, 0 or >0 like for qsort()
+ */
+void generic_sort(void* base, size_t count, size_t size,
+                  int (*compare)(const void*, const void*)) {
+    if (count < 2 || size == 0) {
+        return;
+    }
+
+    int depth = 0;
+    for (size_t n = count; n > 1; n >>= 1) {
+        depth += 2;
+    }
+
+    generic_introsort_loop(base, 0, count, depth, size, compare);
+}
@@ -0,0 +1,211 @@
+/**
+ * @file keyed_sorting.c
+ * @brief Argsort and key/payload (struct-of-arrays) sorting
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Each key is packed with its index into one 64-bit word: the key, with
+ * its sign bit flipped so unsigned order matches signed order, in the high
+ * half and the index in the low half. The words are sorted with the
+ * existing engines, so only 8 bytes per element move during the sort:
+ * large inputs use LSD radix sort over the key half (stable either way);
+ * small ones use a key-only merge sort when stability is required and a
+ * key-only introsort otherwise, which is also the unstable fallback if the
+ * radix buffers cannot be allocated.
+ * The resulting index order is then applied to each payload array with a
+ * single gather pass.
+ */
+
+#include "sorting_algorithms.h"
+
+/* Stable sorts of at least this many elements use radix sort */
+#define KEYED_RADIX_THRESHOLD 1024
+
+/* Order packed words by their key half only */
+#define KEYED_LESS(a, b) (((a) >> 32) < ((b) >> 32))
+
+SORT_DEFINE(keyed, uint64_t, KEYED_LESS)
+
+/**
+ * @brief Pack (key, index) words
+ */
+static void pack_keys(const int keys[], size_t count, uint64_t packed[]) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t key = (uint32_t)keys[i] ^ 0x80000000u;
+        packed[i] = ((uint64_t)key << 32) | (uint64_t)i;
+    }
+}
+
+/**
+ * @brief Key stored in a packed word
+ */
+static int packed_key(uint64_t word) {
+    return (int)(int32_t)((uint32_t)(word >> 32) ^ 0x80000000u);
+}
+
+/**
+ * @brief Index stored in a packed word
+ */
+static size_t packed_index(uint64_t word) {
+    return (size_t)(word & 0xFFFFFFFFu);
+}
+
+/**
+ * @brief Sort packed words by key
+ * @return false if a stable sort could not allocate its scratch buffer
+ *         (words unchanged)
+ */
+static bool sort_packed(uint64_t packed[], size_t count, bool stable) {
+    if (count >= KEYED_RADIX_THRESHOLD &&
+        radix_sort_uint64_high(packed, count, RADIX_DEFAULT_DIGIT_BITS, 32)) {
+        return true;
+    }
+    if (!stable) {
+        keyed_quick_sort(packed, count);
+        return true;
+    }
+    return keyed_merge_sort(packed, count);
+}
+
+/**
+ * @brief Pack the keys and sort them; the caller frees the result
+ * @return Sorted words, or NULL if memory could not be allocated or
+ *         count exceeds the 32-bit index space
+ */
+static uint64_t* sorted_packed_keys(const int keys[], size_t count, bool stable) {
+    if (count > (size_t)UINT32_MAX) {
+        fprintf(stderr, "Keyed sort limited to %lu elements\n", (unsigned long)UINT32_MAX);
+        return NULL;
+    }
+
+    uint64_t* packed = malloc((count > 0 ? count : 1) * sizeof(uint64_t));
+    if (packed == NULL) {
+        return NULL;
+    }
+    pack_keys(keys, count, packed);
+    if (!sort_packed(packed, count, stable)) {
+        free(packed);
+        return NULL;
+    }
+
+    return packed;
+}
+
+/**
+ * @brief Indirect sort: the permutation that sorts the keys
+ *
+ * Afterwards keys[indices[0]] <= keys[indices[1]] <= ...; the keys are
+ * not modified. A stable argsort lists equal keys in index order.
+ * Time Complexity: O(n) (radix) above KEYED_RADIX_THRESHOLD keys, O(n log n) below
+ * Space Complexity: O(n)
+ * @param keys Keys to order
+ * @param count Number of keys (at most UINT32_MAX)
+ * @param indices Receives count indices
+ * @param stable Whether equal keys must keep their relative order
+ * @return false if memory could not be allocated (indices unchanged)
+ */
+bool argsort(const int keys[], size_t count, size_t indices[], bool stable) {
+    uint64_t* packed = sorted_packed_keys(keys, count, stable);
+    if (packed == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        indices[i] = packed_index(packed[i]);
+    }
+
+    free(packed);
+    return true;
+}
+
+/**
+ * @brief Apply a permutation to one payload array: out[i] = in[order[i]]
+ */
+static void gather_payload(unsigned char* payload, unsigned char* buffer, size_t size,
+                           const uint64_t order[], size_t count) {
+    // Common widths get a constant-size memcpy (a single move, with no
+    // alignment or aliasing assumptions) instead of a variable-size call
+    switch (size) {
+        case 1:
+            for (size_t i = 0; i < count; i++) {
+                buffer[i] = payload[packed_index(order[i])];
+            }
+            break;
+        case 2:
+            for (size_t i = 0; i < count; i++) {
+                memcpy(buffer + i * 2, payload + packed_index(order[i]) * 2, 2);
+            }
+            break;
+        case 4:
+            for (size_t i = 0; i < count; i++) {
+                memcpy(buffer + i * 4, payload + packed_index(order[i]) * 4, 4);
+            }
+            break;
+        case 8:
+            for (size_t i = 0; i < count; i++) {
+                memcpy(buffer + i * 8, payload + packed_index(order[i]) * 8, 8);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < count; i++) {
+                memcpy(buffer + i * size, payload + packed_index(order[i]) * size, size);
+            }
+            break;
+    }
+    memcpy(payload, buffer, count * size);
+}
+
+/**
+ * @brief Sort keys together with parallel payload arrays (struct of arrays)
+ *
+ * The keys are sorted through packed (key, index) words; each payload
+ * array is then permuted once with a gather, so payload elements never
+ * move during the sort itself.
+ * Time Complexity: that of argsort(), plus O(n) per payload
+ * Space Complexity: O(n) words plus one buffer of the widest payload
+ * @param keys Keys to sort in place
+ * @param count Number of keys (at most UINT32_MAX)
+ * @param payloads Payload arrays of count elements each
+ * @param payload_sizes Element size in bytes of each payload array
+ * @param payload_count Number of payload arrays (may be 0)
+ * @param stable Whether equal keys must keep their relative order
+ * @return false if memory could not be allocated (all arrays unchanged)
+ */
+bool sort_by_key(int keys[], size_t count, void* const payloads[],
+                 const size_t payload_sizes[], size_t payload_count, bool stable) {
+    if (count < 2) {
+        return true;
+    }
+
+    size_t widest = 0;
+    for (size_t p = 0; p < payload_count; p++) {
+        if (payload_sizes[p] > widest) {
+            widest = payload_sizes[p];
+        }
+    }
+
+    unsigned char* buffer = NULL;
+    if (widest > 0) {
+        buffer = malloc(count * widest);
+        if (buffer == NULL) {
+            return false;
+        }
+    }
+
+    uint64_t* packed = sorted_packed_keys(keys, count, stable);
+    if (packed == NULL) {
+        free(buffer);
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        keys[i] = packed_key(packed[i]);
+    }
+    for (size_t p = 0; p < payload_count; p++) {
+        gather_payload(payloads[p], buffer, payload_sizes[p], packed, count);
+    }
+
+    free(packed);
+    free(buffer);
+    return true;
+}
@@ -9,18 +9,24 @@
 
 /**
  * @brief Create a new node with the given word
+ *
+ * The node and a copy of its text share a single allocation, so the
+ * node can be released with one free().
  * @param word String to store in the node
  * @return Pointer to the new node, or NULL if allocation fails
  */
 Node* create_node(const char* word) {
-    Node* new_node = (Node*)malloc(sizeof(Node));
+    size_t length = strlen(word);
+    Node* new_node = (Node*)malloc(sizeof(Node) + length + 1);
     if (new_node == NULL) {
         printf("Memory allocation failed for new node!\n");
         return NULL;
     }
     
-    strncpy(new_node->word, word, MAX_WORD_LENGTH - 1);
-    new_node->word[MAX_WORD_LENGTH - 1] = '\0'; // Ensure null termination
+    char* text = (char*)(new_node + 1);
+    memcpy(text, word, length + 1);
+    new_node->word = text;
+    new_node->length = length;
     new_node->next = NULL;
     
     return new_node;
@@ -28,6 +34,8 @@ Node* create_node(const char* word) {
 
 /**
  * @brief Insert a new node at the end of the linked list
+ *
+ * Walks the whole list to find the tail; use a WordList to append in O(1).
  * @param head Pointer to the head of the list
  * @param word Word to insert
  */
@@ -51,6 +59,9 @@ void insert_end(Node** head, const char* word) {
 
 /**
  * @brief Free all nodes in the linked list
+ *
+ * Only for lists built with create_node(); lists owned by a WordList are
+ * released with word_list_free().
  * @param head Pointer to the head of the list
  */
 void free_linked_list(Node* head) {
@@ -64,20 +75,182 @@ void free_linked_list(Node* head) {
 
 /**
  * @brief Create a linked list from an array of words
+ *
+ * Keeps a tail pointer, so building the list is O(n).
  * @param words Array of strings
  * @param count Number of words in the array
- * @return Pointer to the head of the created list
+ * @return Pointer to the head of the created list (free with free_linked_list())
  */
 Node* create_linked_list_from_words(const char* words[], int count) {
     Node* head = NULL;
+    Node** tail = &head;
     
     for (int i = 0; i < count; i++) {
-        insert_end(&head, words[i]);
+        Node* new_node = create_node(words[i]);
+        if (new_node == NULL) {
+            break;
+        }
+        *tail = new_node;
+        tail = &new_node->next;
     }
     
     return head;
 }
 
+/* Default size of an arena block when the final size is not known */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/**
+ * @brief Chunk of arena memory; blocks are chained for release
+ */
+struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t used;
+    size_t capacity;
+    max_align_t data[];
+};
+
+/**
+ * @brief Bump-allocate from an arena, adding a block when the current one is full
+ * @param arena Arena to allocate from
+ * @param size Number of bytes
+ * @param align Required alignment (power of two, at most alignof(max_align_t))
+ * @return Pointer to the memory, or NULL if a new block could not be allocated
+ */
+static void* arena_alloc(Arena* arena, size_t size, size_t align) {
+    ArenaBlock* block = arena->blocks;
+    
+    if (block != NULL) {
+        size_t offset = (block->used + align - 1) & ~(align - 1);
+        if (offset + size <= block->capacity) {
+            block->used = offset + size;
+            return (unsigned char*)block->data + offset;
+        }
+    }
+    
+    size_t capacity = size > arena->block_size ? size : arena->block_size;
+    block = malloc(sizeof(ArenaBlock) + capacity);
+    if (block == NULL) {
+        return NULL;
+    }
+    block->next = arena->blocks;
+    block->used = size;
+    block->capacity = capacity;
+    arena->blocks = block;
+    
+    return block->data;
+}
+
+/**
+ * @brief Release every block of an arena
+ */
+static void arena_free(Arena* arena) {
+    ArenaBlock* block = arena->blocks;
+    while (block != NULL) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->blocks = NULL;
+}
+
+/**
+ * @brief Initialize an empty word list
+ * @param list List to initialize
+ */
+void word_list_init(WordList* list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->count = 0;
+    list->nodes.blocks = NULL;
+    list->nodes.block_size = ARENA_BLOCK_SIZE;
+    list->strings.blocks = NULL;
+    list->strings.block_size = ARENA_BLOCK_SIZE;
+}
+
+/**
+ * @brief Append a word in O(1)
+ *
+ * The node comes from the list's node pool and the text is copied into
+ * its contiguous string arena. The list may have been reordered by a
+ * sort since the last append: the tail is then re-found by walking
+ * forward from the previous tail.
+ * @param list List to append to
+ * @param word Text of the word (need not be NUL-terminated)
+ * @param length Length of the text in bytes
+ * @return false if memory could not be allocated (list unchanged)
+ */
+bool word_list_append(WordList* list, const char* word, size_t length) {
+    char* text = arena_alloc(&list->strings, length + 1, 1);
+    Node* node = arena_alloc(&list->nodes, sizeof(Node), _Alignof(Node));
+    if (text == NULL || node == NULL) {
+        return false;
+    }
+    
+    memcpy(text, word, length);
+    text[length] = '\0';
+    node->word = text;
+    node->length = length;
+    node->next = NULL;
+    
+    if (list->head == NULL) {
+        list->head = node;
+    } else {
+        while (list->tail->next != NULL) {
+            list->tail = list->tail->next;
+        }
+        list->tail->next = node;
+    }
+    list->tail = node;
+    list->count++;
+    
+    return true;
+}
+
+/**
+ * @brief Build a word list from an array of words
+ *
+ * Sizes the node pool and string arena exactly up front, so the whole
+ * list lives in two allocations.
+ * @param list List to fill (initialized by this call)
+ * @param words Array of strings
+ * @param count Number of words in the array
+ * @return false if memory could not be allocated (list left empty)
+ */
+bool word_list_build(WordList* list, const char* words[], size_t count) {
+    word_list_init(list);
+    
+    size_t text_bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        text_bytes += strlen(words[i]) + 1;
+    }
+    if (count > 0) {
+        list->nodes.block_size = count * sizeof(Node);
+        list->strings.block_size = text_bytes;
+    }
+    
+    for (size_t i = 0; i < count; i++) {
+        if (!word_list_append(list, words[i], strlen(words[i]))) {
+            word_list_free(list);
+            return false;
+        }
+    }
+    
+    list->nodes.block_size = ARENA_BLOCK_SIZE;
+    list->strings.block_size = ARENA_BLOCK_SIZE;
+    return true;
+}
+
+/**
+ * @brief Release all nodes and text of a word list at once
+ * @param list List to free (left empty and reusable)
+ */
+void word_list_free(WordList* list) {
+    arena_free(&list->nodes);
+    arena_free(&list->strings);
+    word_list_init(list);
+}
+
 /**
  * @brief Insertion Sort for Linked List
  * Time Complexity: O(n²)
@@ -85,8 +258,6 @@ Node* create_linked_list_from_words(const char* words[], int count) {
  * @param head Pointer to the head of the linked list
  */
 void insertion_sort_linked_list(Node** head) {
-    printf("\n=== Insertion Sort for Linked List ===\n");
-    
     if (*head == NULL || (*head)->next == NULL) {
         return;
     }
@@ -101,22 +272,21 @@ void insertion_sort_linked_list(Node** head) {
         if (sorted == NULL || strcmp(sorted->word, current->word) >= 0) {
             current->next = sorted;
             sorted = current;
-            permutation_count++;
+            SORT_COUNT_PERMUTATION();
         } else {
             Node* temp = sorted;
             while (temp->next != NULL && strcmp(temp->next->word, current->word) < 0) {
-                comparison_count++;
+                SORT_COUNT_COMPARISON();
                 temp = temp->next;
             }
-            comparison_count++;
+            SORT_COUNT_COMPARISON();
             
             current->next = temp->next;
             temp->next = current;
-            permutation_count++;
+            SORT_COUNT_PERMUTATION();
         }
         
-        printf("After inserting '%s': ", current->word);
-        display_linked_list(sorted);
+        SORT_TRACE_LIST(sorted, "After inserting '%s': ", current->word);
         current = next;
     }
     
@@ -124,18 +294,48 @@ void insertion_sort_linked_list(Node** head) {
 }
 
 /**
- * @brief Bubble Sort for Linked List
- * Time Complexity: O(n²)
- * Space Complexity: O(1)
- * @param head Pointer to the head of the linked list
+ * @brief Number of nodes in a list
  */
-void bubble_sort_linked_list(Node** head) {
-    printf("\n=== Bubble Sort for Linked List ===\n");
-    
-    if (*head == NULL || (*head)->next == NULL) {
-        return;
+static size_t list_length(const Node* head) {
+    size_t count = 0;
+    for (; head != NULL; head = head->next) {
+        count++;
     }
-    
+    return count;
+}
+
+/**
+ * @brief Load the nodes of a list into an array and their words into
+ *        prefix keys tagged with the node position
+ */
+static void load_word_keys(Node* head, Node* nodes[], PrefixKey keys[]) {
+    for (size_t i = 0; head != NULL; head = head->next, i++) {
+        nodes[i] = head;
+        keys[i].text = head->word;
+        keys[i].prefix = string_prefix(head->word);
+        keys[i].tag = i;
+    }
+}
+
+/**
+ * @brief Relink the nodes in the order held by a key array
+ * @return Next link of the last node (set to NULL)
+ */
+static Node** relink_by_keys(Node** head, Node* nodes[], const PrefixKey keys[], size_t count) {
+    Node** link = head;
+    for (size_t i = 0; i < count; i++) {
+        *link = nodes[keys[i].tag];
+        link = &(*link)->next;
+    }
+    *link = NULL;
+    return link;
+}
+
+/**
+ * @brief Bubble sort by swapping the contents of adjacent nodes
+ *        (fallback when the key arrays cannot be allocated)
+ */
+static void bubble_sort_nodes(Node** head) {
     bool swapped;
     Node* ptr1;
     Node* last_ptr = NULL;
@@ -145,23 +345,251 @@ void bubble_sort_linked_list(Node** head) {
         ptr1 = *head;
         
         while (ptr1->next != last_ptr) {
-            comparison_count++;
+            SORT_COUNT_COMPARISON();
             if (strcmp(ptr1->word, ptr1->next->word) > 0) {
-                // Swap words
-                char temp[MAX_WORD_LENGTH];
-                strcpy(temp, ptr1->word);
-                strcpy(ptr1->word, ptr1->next->word);
-                strcpy(ptr1->next->word, temp);
+                // Swap word references (the text itself is not copied)
+                const char* temp_word = ptr1->word;
+                size_t temp_length = ptr1->length;
+                ptr1->word = ptr1->next->word;
+                ptr1->length = ptr1->next->length;
+                ptr1->next->word = temp_word;
+                ptr1->next->length = temp_length;
                 
                 swapped = true;
-                permutation_count++;
+                SORT_COUNT_PERMUTATION();
             }
             ptr1 = ptr1->next;
         }
         
         last_ptr = ptr1;
-        printf("After iteration: ");
-        display_linked_list(*head);
+        SORT_TRACE_LIST(*head, "After iteration: ");
         
     } while (swapped);
 }
+
+/**
+ * @brief Bubble Sort for Linked List
+ *
+ * Sorts an array of (prefix, word) keys, so most comparisons are integer
+ * compares of the cached 8-byte prefixes, then relinks the nodes once.
+ * Falls back to swapping node contents if the arrays cannot be allocated.
+ * Time Complexity: O(n²)
+ * Space Complexity: O(n)
+ * @param head Pointer to the head of the linked list
+ */
+void bubble_sort_linked_list(Node** head) {
+    if (*head == NULL || (*head)->next == NULL) {
+        return;
+    }
+    
+    size_t count = list_length(*head);
+    Node** nodes = malloc(count * sizeof(Node*));
+    PrefixKey* keys = malloc(count * sizeof(PrefixKey));
+    if (nodes == NULL || keys == NULL) {
+        free(nodes);
+        free(keys);
+        bubble_sort_nodes(head);
+        return;
+    }
+    load_word_keys(*head, nodes, keys);
+    
+    for (size_t end = count; end > 1; end--) {
+        bool swapped = prefix_key_bubble_pass(keys, end);
+        
+        if (SORT_TRACE_ENABLED()) {
+            relink_by_keys(head, nodes, keys, count);
+        }
+        SORT_TRACE_LIST(*head, "After iteration: ");
+        
+        if (!swapped) {
+            break;
+        }
+    }
+    
+    relink_by_keys(head, nodes, keys, count);
+    free(nodes);
+    free(keys);
+}
+
+/**
+ * @brief Detach the first `length` nodes of a list
+ * @param start First node of the run (may be NULL)
+ * @param length Number of nodes to keep in the run
+ * @return First node after the run, or NULL
+ */
+static Node* split_run(Node* start, size_t length) {
+    for (size_t i = 1; start != NULL && i < length; i++) {
+        start = start->next;
+    }
+    if (start == NULL) {
+        return NULL;
+    }
+    
+    Node* rest = start->next;
+    start->next = NULL;
+    return rest;
+}
+
+/**
+ * @brief Stable merge of two sorted runs, appended at *tail
+ * @param left First run (wins ties)
+ * @param right Second run
+ * @param tail Link to append to; updated to the last node's next link
+ */
+static void merge_runs_into(Node* left, Node* right, Node*** tail) {
+    Node** link = *tail;
+    
+    while (left != NULL && right != NULL) {
+        SORT_COUNT_COMPARISON();
+        if (strcmp(left->word, right->word) <= 0) {
+            *link = left;
+            left = left->next;
+        } else {
+            *link = right;
+            right = right->next;
+        }
+        SORT_COUNT_PERMUTATION();
+        link = &(*link)->next;
+    }
+    
+    // Attach the leftover run and walk to its end
+    *link = (left != NULL) ? left : right;
+    while (*link != NULL) {
+        link = &(*link)->next;
+    }
+    
+    *tail = link;
+}
+
+/**
+ * @brief Bottom-up merge passes by rewiring next pointers
+ * @param head Pointer to the head of the list
+ * @param width Length of the sorted runs the list already consists of
+ */
+static void merge_sort_nodes(Node** head, size_t width) {
+    for (; ; width *= 2) {
+        Node* remaining = *head;
+        Node* merged = NULL;
+        Node** tail = &merged;
+        Node* right = NULL;
+        size_t merges = 0;
+        
+        while (remaining != NULL) {
+            Node* left = remaining;
+            right = split_run(left, width);
+            remaining = split_run(right, width);
+            merge_runs_into(left, right, &tail);
+            merges++;
+        }
+        
+        *head = merged;
+        if (merges == 1 && right == NULL) {
+            break; // the list was already a single run
+        }
+        SORT_TRACE_LIST(*head, "After merge pass (width %zu): ", width);
+        
+        if (merges <= 1) {
+            break;
+        }
+    }
+}
+
+/* Nodes per run sorted through prefix keys by merge_sort_linked_list_bounded() */
+#define LIST_KEY_RUN 1024
+
+/**
+ * @brief Sort consecutive runs of up to `run` nodes through prefix keys
+ * @param head Pointer to the head of the list
+ * @param run Run length; nodes and keys hold run and 2 * run entries
+ */
+static void sort_runs_by_keys(Node** head, size_t run, Node* nodes[], PrefixKey keys[]) {
+    Node** link = head;
+    while (*link != NULL) {
+        Node* rest = split_run(*link, run);
+        size_t count = list_length(*link);
+        load_word_keys(*link, nodes, keys);
+        
+        PrefixKey* src = keys;
+        PrefixKey* dst = keys + run;
+        
+        for (size_t width = 1; width < count; width *= 2) {
+            prefix_key_merge_pass(src, dst, count, width);
+            
+            PrefixKey* temp = src;
+            src = dst;
+            dst = temp;
+            
+            if (SORT_TRACE_ENABLED()) {
+                *relink_by_keys(link, nodes, src, count) = rest;
+            }
+            SORT_TRACE_LIST(*head, "After merge pass (width %zu): ", width);
+        }
+        
+        link = relink_by_keys(link, nodes, src, count);
+        *link = rest;
+    }
+}
+
+/**
+ * @brief Merge Sort for Linked List
+ *
+ * Bottom-up and stable. The words are loaded as (prefix, word) keys so
+ * most comparisons are integer compares of the cached 8-byte prefixes
+ * instead of pointer chases into the nodes; the nodes are relinked once
+ * at the end and their contents are never copied. The key arrays take
+ * about 56 bytes per node; merge_sort_linked_list_bounded() sorts in
+ * O(1) extra memory and is used if they cannot be allocated.
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(n)
+ * @param head Pointer to the head of the linked list
+ */
+void merge_sort_linked_list(Node** head) {
+    if (*head == NULL || (*head)->next == NULL) {
+        return;
+    }
+    
+    size_t count = list_length(*head);
+    Node** nodes = malloc(count * sizeof(Node*));
+    PrefixKey* keys = malloc(2 * count * sizeof(PrefixKey));
+    if (nodes == NULL || keys == NULL) {
+        free(nodes);
+        free(keys);
+        merge_sort_linked_list_bounded(head);
+        return;
+    }
+    
+    sort_runs_by_keys(head, count, nodes, keys);
+    free(nodes);
+    free(keys);
+}
+
+/**
+ * @brief Merge Sort for Linked List in O(1) extra memory
+ *
+ * Bottom-up and stable. Runs of LIST_KEY_RUN nodes are sorted through
+ * prefix keys in one fixed buffer; the runs are then merged by rewiring
+ * next pointers, comparing the words with strcmp(). Slower than
+ * merge_sort_linked_list() on long lists, but the extra memory does not
+ * grow with the list. Without the buffer, every pass rewires pointers.
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(1)
+ * @param head Pointer to the head of the linked list
+ */
+void merge_sort_linked_list_bounded(Node** head) {
+    if (*head == NULL || (*head)->next == NULL) {
+        return;
+    }
+    
+    size_t run = LIST_KEY_RUN;
+    Node** nodes = malloc(run * sizeof(Node*));
+    PrefixKey* keys = malloc(2 * run * sizeof(PrefixKey));
+    if (nodes == NULL || keys == NULL) {
+        run = 1;
+    } else {
+        sort_runs_by_keys(head, run, nodes, keys);
+    }
+    free(nodes);
+    free(keys);
+    
+    merge_sort_nodes(head, run);
+}
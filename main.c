@@ -37,20 +37,31 @@ void run_array_sorting_demo(void) {
     printf("4. Quick Sort\n");
     printf("5. Merge Sort\n");
     printf("6. Comb Sort\n");
+    printf("7. Radix Sort\n");
+    printf("8. Auto Sort (adaptive)\n");
+    printf("9. Pattern-Defeating Quicksort\n");
     
-    int choice = get_user_choice(1, 6, "Enter your choice: ");
+    int choice = get_user_choice(1, 9, "Enter your choice: ");
+    SortProbe probe;
+    probe.reason = NULL;
     
+    PerfCounters perf;
+    perf_counters_open(&perf);
     reset_counters();
+    perf_counters_start(&perf);
     
     // Apply chosen algorithm
     switch (choice) {
         case 1:
+            printf("\n=== Selection Sort ===\n");
             selection_sort(arr, size);
             break;
         case 2:
+            printf("\n=== Bubble Sort ===\n");
             bubble_sort(arr, size);
             break;
         case 3:
+            printf("\n=== Insertion Sort ===\n");
             insertion_sort(arr, size);
             break;
         case 4:
@@ -62,13 +73,32 @@ void run_array_sorting_demo(void) {
             merge_sort(arr, 0, size - 1);
             break;
         case 6:
+            printf("\n=== Comb Sort ===\n");
             comb_sort(arr, size);
             break;
+        case 7:
+            printf("\n=== Radix Sort ===\n");
+            radix_sort(arr, size);
+            break;
+        case 8:
+            printf("\n=== Auto Sort ===\n");
+            auto_sort(arr, size, &probe);
+            break;
+        case 9:
+            printf("\n=== Pattern-Defeating Quicksort ===\n");
+            pdq_sort(arr, size);
+            break;
     }
+    perf_counters_stop(&perf);
     
     printf("\nArray after sorting: ");
     display_array(arr, size);
+    if (probe.reason != NULL) {
+        print_sort_probe(&probe);
+    }
     print_statistics();
+    print_perf_counters(&perf);
+    perf_counters_close(&perf);
     
     free(arr);
 }
@@ -82,37 +112,68 @@ void run_linked_list_sorting_demo(void) {
     // Create linked list with sample words
     const char* words[] = {"apple", "banana", "cherry", "date", "elderberry", 
                           "fig", "grape", "honeydew", "kiwi", "lemon"};
-    int word_count = sizeof(words) / sizeof(words[0]);
+    size_t word_count = sizeof(words) / sizeof(words[0]);
     
-    Node* head = create_linked_list_from_words(words, word_count);
+    WordList list;
+    if (!word_list_build(&list, words, word_count)) {
+        printf("Memory allocation failed for word list!\n");
+        return;
+    }
     
     printf("Linked list before sorting: ");
-    display_linked_list(head);
+    display_linked_list(list.head);
     
     // Get sorting algorithm choice
     printf("\nChoose sorting algorithm:\n");
     printf("1. Insertion Sort\n");
     printf("2. Bubble Sort\n");
+    printf("3. Merge Sort\n");
+    printf("4. Multikey Quicksort\n");
+    printf("5. MSD Radix Sort\n");
     
-    int choice = get_user_choice(1, 2, "Enter your choice: ");
+    int choice = get_user_choice(1, 5, "Enter your choice: ");
     
+    PerfCounters perf;
+    perf_counters_open(&perf);
     reset_counters();
+    perf_counters_start(&perf);
     
     // Apply chosen algorithm
     switch (choice) {
         case 1:
-            insertion_sort_linked_list(&head);
+            printf("\n=== Insertion Sort for Linked List ===\n");
+            insertion_sort_linked_list(&list.head);
             break;
         case 2:
-            bubble_sort_linked_list(&head);
+            printf("\n=== Bubble Sort for Linked List ===\n");
+            bubble_sort_linked_list(&list.head);
+            break;
+        case 3:
+            printf("\n=== Merge Sort for Linked List ===\n");
+            merge_sort_linked_list(&list.head);
+            break;
+        case 4:
+            printf("\n=== Multikey Quicksort for Linked List ===\n");
+            if (!multikey_sort_linked_list(&list.head)) {
+                printf("Memory allocation failed for multikey quicksort!\n");
+            }
+            break;
+        case 5:
+            printf("\n=== MSD Radix Sort for Linked List ===\n");
+            if (!msd_radix_sort_linked_list(&list.head)) {
+                printf("Memory allocation failed for MSD radix sort!\n");
+            }
             break;
     }
+    perf_counters_stop(&perf);
     
     printf("\nLinked list after sorting: ");
-    display_linked_list(head);
+    display_linked_list(list.head);
     print_statistics();
+    print_perf_counters(&perf);
+    perf_counters_close(&perf);
     
-    free_linked_list(head);
+    word_list_free(&list);
 }
 
 /**
@@ -122,45 +183,87 @@ void run_matrix_sorting_demo(void) {
     printf("\n=== Matrix Sorting Demonstration ===\n");
     
     // Create and initialize matrix
-    char matrix[MAX_ROWS][MAX_COLS];
-    generate_random_matrix(matrix);
+    StringTable matrix;
+    string_table_init(&matrix);
+    if (!generate_random_matrix(&matrix, MATRIX_DEMO_ROWS, MATRIX_DEMO_WIDTH)) {
+        printf("Memory allocation failed for matrix!\n");
+        string_table_free(&matrix);
+        return;
+    }
     
     printf("Matrix before sorting:\n");
-    display_matrix(matrix, MAX_ROWS);
+    display_matrix(&matrix);
     
     // Get sorting algorithm choice
     printf("Choose sorting algorithm:\n");
     printf("1. Bubble Sort\n");
     printf("2. Merge Sort\n");
+    printf("3. Multikey Quicksort\n");
+    printf("4. MSD Radix Sort\n");
     
-    int choice = get_user_choice(1, 2, "Enter your choice: ");
+    int choice = get_user_choice(1, 4, "Enter your choice: ");
     
+    PerfCounters perf;
+    perf_counters_open(&perf);
     reset_counters();
+    perf_counters_start(&perf);
     
     // Apply chosen algorithm
     switch (choice) {
         case 1:
-            bubble_sort_matrix(matrix, MAX_ROWS);
+            printf("\n=== Bubble Sort for Matrix ===\n");
+            if (!bubble_sort_matrix(&matrix)) {
+                printf("Memory allocation failed for bubble sort!\n");
+            }
             break;
         case 2:
             printf("\n=== Merge Sort for Matrix ===\n");
-            merge_sort_matrix(matrix, 0, MAX_ROWS - 1);
+            if (!merge_sort_matrix(&matrix)) {
+                printf("Memory allocation failed for merge sort!\n");
+            }
+            break;
+        case 3:
+            printf("\n=== Multikey Quicksort for Matrix ===\n");
+            if (!multikey_sort_matrix(&matrix)) {
+                printf("Memory allocation failed for multikey quicksort!\n");
+            }
+            break;
+        case 4:
+            printf("\n=== MSD Radix Sort for Matrix ===\n");
+            if (!msd_radix_sort_matrix(&matrix)) {
+                printf("Memory allocation failed for MSD radix sort!\n");
+            }
             break;
     }
+    perf_counters_stop(&perf);
     
     printf("\nMatrix after sorting:\n");
-    display_matrix(matrix, MAX_ROWS);
+    display_matrix(&matrix);
     print_statistics();
+    print_perf_counters(&perf);
+    perf_counters_close(&perf);
+    
+    string_table_free(&matrix);
 }
 
 /**
  * @brief Main function
+ * @param argc Argument count
+ * @param argv Arguments (any argument selects the command-line mode)
  * @return Exit status
  */
-int main(void) {
+int main(int argc, char* argv[]) {
+    // Any argument selects the command-line mode (see cli.c)
+    if (argc > 1) {
+        return run_cli(argc, argv);
+    }
+    
     // Initialize random seed
     srand((unsigned int)time(NULL));
     
+    // Show every sorting step while the demo runs
+    set_sort_observer(&printing_observer);
+    
     printf("Welcome to the Professional Sorting Algorithms Demo!\n");
     printf("This program demonstrates various sorting algorithms\n");
     printf("with performance analysis and step-by-step visualization.\n");
@@ -1,136 +1,260 @@
 /**
  * @file matrix_sorting.c
- * @brief Implementation of sorting algorithms for string matrices
+ * @brief Runtime-sized string table and its sorting algorithms
  * @author Professional C Developer
  * @date 2024
+ *
+ * The rows of a StringTable are stored back to back in one character
+ * buffer and located through an offsets array. Sorting never moves row
+ * text: it permutes the table's order array of row indices, so a sort
+ * costs the same whatever the row width.
  */
 
 #include "sorting_algorithms.h"
 
+/* Initial capacities of an empty table (both grow by doubling) */
+#define TABLE_INITIAL_ROWS 16
+#define TABLE_INITIAL_BYTES 256
+
+/**
+ * @brief Text of the row with index `row` (insertion order)
+ */
+static const char* row_text(const StringTable* table, size_t row) {
+    return table->data + table->offsets[row];
+}
+
+/**
+ * @brief Initialize an empty table
+ * @param table Table to initialize
+ */
+void string_table_init(StringTable* table) {
+    table->data = NULL;
+    table->data_size = 0;
+    table->data_capacity = 0;
+    table->offsets = NULL;
+    table->order = NULL;
+    table->rows = 0;
+    table->row_capacity = 0;
+}
+
 /**
- * @brief Generate a random matrix of strings
- * @param matrix Matrix to fill with random strings
+ * @brief Make room for at least `rows` rows and `bytes` bytes of text
+ *        (NUL terminators included) in total
+ * @param table Table to grow
+ * @param rows Total number of rows to accommodate
+ * @param bytes Total number of text bytes to accommodate
+ * @return false if memory could not be allocated (table unchanged)
  */
-void generate_random_matrix(char matrix[MAX_ROWS][MAX_COLS]) {
-    for (int i = 0; i < MAX_ROWS; i++) {
-        for (int j = 0; j < MAX_COLS - 1; j++) {
-            matrix[i][j] = 'a' + rand() % 26; // Random lowercase letters
+bool string_table_reserve(StringTable* table, size_t rows, size_t bytes) {
+    if (bytes > table->data_capacity) {
+        char* data = realloc(table->data, bytes);
+        if (data == NULL) {
+            return false;
         }
-        matrix[i][MAX_COLS - 1] = '\0'; // Null terminate
+        table->data = data;
+        table->data_capacity = bytes;
     }
+
+    if (rows > table->row_capacity) {
+        size_t* offsets = realloc(table->offsets, rows * sizeof(size_t));
+        if (offsets == NULL) {
+            return false;
+        }
+        table->offsets = offsets;
+
+        size_t* order = realloc(table->order, rows * sizeof(size_t));
+        if (order == NULL) {
+            return false;
+        }
+        table->order = order;
+        table->row_capacity = rows;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Append a row at the end of the table
+ * @param table Table to append to
+ * @param text Row text (need not be NUL-terminated)
+ * @param length Length of the text in bytes
+ * @return false if memory could not be allocated (table unchanged)
+ */
+bool string_table_append(StringTable* table, const char* text, size_t length) {
+    size_t rows = table->row_capacity;
+    size_t bytes = table->data_capacity;
+
+    if (table->rows == rows) {
+        rows = rows > 0 ? 2 * rows : TABLE_INITIAL_ROWS;
+    }
+    while (table->data_size + length + 1 > bytes) {
+        bytes = bytes > 0 ? 2 * bytes : TABLE_INITIAL_BYTES;
+    }
+    if (!string_table_reserve(table, rows, bytes)) {
+        return false;
+    }
+
+    memcpy(table->data + table->data_size, text, length);
+    table->data[table->data_size + length] = '\0';
+    table->offsets[table->rows] = table->data_size;
+    table->order[table->rows] = table->rows;
+    table->data_size += length + 1;
+    table->rows++;
+
+    return true;
+}
+
+/**
+ * @brief Row at a position of the current (sorted) order
+ * @param table Table to read
+ * @param position Position in [0, rows)
+ * @return NUL-terminated row text
+ */
+const char* string_table_row(const StringTable* table, size_t position) {
+    return row_text(table, table->order[position]);
+}
+
+/**
+ * @brief Release the storage of a table (left empty and reusable)
+ * @param table Table to free
+ */
+void string_table_free(StringTable* table) {
+    free(table->data);
+    free(table->offsets);
+    free(table->order);
+    string_table_init(table);
 }
 
 /**
- * @brief Merge function for matrix merge sort
- * @param matrix Matrix to merge
- * @param left Left boundary
- * @param mid Middle index
- * @param right Right boundary
+ * @brief Fill a table with random lowercase rows
+ * @param table Table to fill (its previous rows are kept)
+ * @param rows Number of rows to add
+ * @param width Number of letters per row
+ * @return false if memory could not be allocated
  */
-void merge_matrices(char matrix[MAX_ROWS][MAX_COLS], int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
-    
-    // Create temporary matrices
-    char left_matrix[n1][MAX_COLS];
-    char right_matrix[n2][MAX_COLS];
-    
-    // Copy data to temporary matrices
-    for (int i = 0; i < n1; i++) {
-        strcpy(left_matrix[i], matrix[left + i]);
-    }
-    for (int j = 0; j < n2; j++) {
-        strcpy(right_matrix[j], matrix[mid + 1 + j]);
-    }
-    
-    // Merge the temporary matrices back
-    int i = 0, j = 0, k = left;
-    
-    while (i < n1 && j < n2) {
-        comparison_count++;
-        if (strcmp(left_matrix[i], right_matrix[j]) <= 0) {
-            strcpy(matrix[k], left_matrix[i]);
-            i++;
-        } else {
-            strcpy(matrix[k], right_matrix[j]);
-            j++;
+bool generate_random_matrix(StringTable* table, size_t rows, size_t width) {
+    if (!string_table_reserve(table, table->rows + rows,
+                              table->data_size + rows * (width + 1))) {
+        return false;
+    }
+
+    char* row = malloc(width + 1);
+    if (row == NULL) {
+        return false;
+    }
+
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < width; j++) {
+            row[j] = 'a' + rand() % 26; // Random lowercase letters
         }
-        permutation_count++;
-        k++;
-    }
-    
-    // Copy remaining elements
-    while (i < n1) {
-        strcpy(matrix[k], left_matrix[i]);
-        i++;
-        k++;
-        permutation_count++;
-    }
-    
-    while (j < n2) {
-        strcpy(matrix[k], right_matrix[j]);
-        j++;
-        k++;
-        permutation_count++;
+        string_table_append(table, row, width);
+    }
+
+    free(row);
+    return true;
+}
+
+/**
+ * @brief Load the rows of a table, in their current order, as prefix keys
+ *        tagged with their row index
+ */
+static void load_row_keys(const StringTable* table, PrefixKey keys[]) {
+    for (size_t i = 0; i < table->rows; i++) {
+        keys[i].text = row_text(table, table->order[i]);
+        keys[i].prefix = string_prefix(keys[i].text);
+        keys[i].tag = table->order[i];
+    }
+}
+
+/**
+ * @brief Store the row order held by a key array into the table
+ */
+static void store_row_order(StringTable* table, const PrefixKey keys[]) {
+    for (size_t i = 0; i < table->rows; i++) {
+        table->order[i] = keys[i].tag;
     }
 }
 
 /**
  * @brief Bubble Sort for Matrix
+ *
+ * Swaps (prefix, row) keys, never row text; strcmp() only runs when the
+ * cached 8-byte prefixes tie.
  * Time Complexity: O(n²)
- * Space Complexity: O(1)
- * @param matrix Matrix to sort
- * @param rows Number of rows in the matrix
+ * Space Complexity: O(n)
+ * @param table Table to sort
+ * @return false if the key array could not be allocated (table unchanged)
  */
-void bubble_sort_matrix(char matrix[MAX_ROWS][MAX_COLS], int rows) {
-    printf("\n=== Bubble Sort for Matrix ===\n");
-    
-    for (int i = 0; i < rows - 1; i++) {
-        bool swapped = false;
-        
-        for (int j = 0; j < rows - i - 1; j++) {
-            comparison_count++;
-            if (strcmp(matrix[j], matrix[j + 1]) > 0) {
-                // Swap rows
-                char temp[MAX_COLS];
-                strcpy(temp, matrix[j]);
-                strcpy(matrix[j], matrix[j + 1]);
-                strcpy(matrix[j + 1], temp);
-                
-                swapped = true;
-                permutation_count++;
-            }
+bool bubble_sort_matrix(StringTable* table) {
+    if (table->rows < 2) {
+        return true;
+    }
+
+    PrefixKey* keys = malloc(table->rows * sizeof(PrefixKey));
+    if (keys == NULL) {
+        return false;
+    }
+    load_row_keys(table, keys);
+
+    for (size_t i = 0; i + 1 < table->rows; i++) {
+        bool swapped = prefix_key_bubble_pass(keys, table->rows - i);
+
+        if (SORT_TRACE_ENABLED()) {
+            store_row_order(table, keys);
         }
-        
-        printf("After iteration %d:\n", i + 1);
-        display_matrix(matrix, rows);
-        
+        SORT_TRACE_MATRIX(table, "After iteration %zu:\n", i + 1);
+
         // Early termination if no swaps occurred
         if (!swapped) {
-            printf("Matrix is already sorted. Terminating early.\n");
+            SORT_TRACE_MESSAGE("Matrix is already sorted. Terminating early.");
             break;
         }
     }
+
+    store_row_order(table, keys);
+    free(keys);
+    return true;
 }
 
 /**
  * @brief Merge Sort for Matrix
+ *
+ * Bottom-up and stable; merges (prefix, row) keys between two arrays and
+ * calls strcmp() only when the cached 8-byte prefixes tie.
  * Time Complexity: O(n log n)
  * Space Complexity: O(n)
- * @param matrix Matrix to sort
- * @param left Left boundary
- * @param right Right boundary
+ * @param table Table to sort
+ * @return false if the key arrays could not be allocated (table unchanged)
  */
-void merge_sort_matrix(char matrix[MAX_ROWS][MAX_COLS], int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-        
-        merge_sort_matrix(matrix, left, mid);
-        merge_sort_matrix(matrix, mid + 1, right);
-        merge_matrices(matrix, left, mid, right);
-        
-        printf("After merging subarrays [%d-%d] and [%d-%d]:\n", 
-               left, mid, mid + 1, right);
-        display_matrix(matrix, right + 1);
+bool merge_sort_matrix(StringTable* table) {
+    size_t rows = table->rows;
+    if (rows < 2) {
+        return true;
+    }
+
+    PrefixKey* keys = malloc(2 * rows * sizeof(PrefixKey));
+    if (keys == NULL) {
+        return false;
+    }
+    load_row_keys(table, keys);
+
+    PrefixKey* src = keys;
+    PrefixKey* dst = keys + rows;
+
+    for (size_t width = 1; width < rows; width *= 2) {
+        prefix_key_merge_pass(src, dst, rows, width);
+
+        PrefixKey* temp = src;
+        src = dst;
+        dst = temp;
+
+        if (SORT_TRACE_ENABLED()) {
+            store_row_order(table, src);
+        }
+        SORT_TRACE_MATRIX(table, "After merge pass (width %zu):\n", width);
     }
+
+    store_row_order(table, src);
+    free(keys);
+    return true;
 }
@@ -0,0 +1,348 @@
+/**
+ * @file multiway_sorting.c
+ * @brief Cache-aware multiway merge sort
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * merge_sort() merges pairs of runs, so a large array streams through
+ * memory about log2(n) times. Here blocks that fit in the L2 cache are
+ * sorted first, where their passes cost no memory traffic. The sorted
+ * blocks are then merged k at a time through a loser tree, with k chosen
+ * so that one cache line per input run stays in L1. Only about
+ * log_k(n / block) passes touch memory. The cache sizes come from Linux
+ * sysfs and are read once.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sorting_algorithms.h"
+#include <pthread.h>
+
+/* Cache geometry assumed when sysfs does not describe the caches */
+#define DEFAULT_L1D_SIZE (32 * 1024)
+#define DEFAULT_L2_SIZE (256 * 1024)
+#define DEFAULT_CACHE_LINE 64
+
+/* Number of cache descriptions probed under sysfs */
+#define CACHE_INDEX_LIMIT 16
+
+/* Bounds of the block sorted in cache, in elements */
+#define MULTIWAY_MIN_BLOCK 4096
+#define MULTIWAY_MAX_BLOCK (16 * 1024 * 1024)
+
+/* Bounds of the merge fan-in */
+#define MULTIWAY_MAX_FAN_IN 1024
+
+/* Run field of a packed word; exhausted runs set the flag bit above it */
+#define MULTIWAY_RUN_MASK 0x7FFFFFFFu
+#define MULTIWAY_EXHAUSTED_FLAG 0x80000000u
+
+static pthread_once_t caches_once = PTHREAD_ONCE_INIT;
+static CacheSizes detected_caches;
+static bool caches_from_sysfs;
+
+/**
+ * @brief Read the first line of a small sysfs file
+ * @return false if the file cannot be read
+ */
+static bool read_sysfs_line(const char* path, char text[], size_t capacity) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) {
+        return false;
+    }
+    bool ok = fgets(text, (int)capacity, file) != NULL;
+    fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Read a cache attribute such as "level" or "size"
+ * @return false if the attribute does not exist
+ */
+static bool read_cache_attribute(int index, const char* name, char text[], size_t capacity) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/%s", index, name);
+    return read_sysfs_line(path, text, capacity);
+}
+
+/**
+ * @brief Parse a sysfs size such as "48K" or "2048K" into bytes
+ */
+static size_t parse_cache_size(const char* text) {
+    char* end;
+    unsigned long value = strtoul(text, &end, 10);
+
+    switch (*end) {
+        case 'K':
+            return (size_t)value * 1024;
+        case 'M':
+            return (size_t)value * 1024 * 1024;
+        case 'G':
+            return (size_t)value * 1024 * 1024 * 1024;
+        default:
+            return (size_t)value;
+    }
+}
+
+static void read_caches(void) {
+    CacheSizes* caches = &detected_caches;
+    char text[64];
+
+    memset(caches, 0, sizeof(*caches));
+    for (int index = 0; index < CACHE_INDEX_LIMIT; index++) {
+        if (!read_cache_attribute(index, "level", text, sizeof(text))) {
+            break;
+        }
+        int level = atoi(text);
+        if (!read_cache_attribute(index, "type", text, sizeof(text)) ||
+            strncmp(text, "Instruction", 11) == 0 ||
+            !read_cache_attribute(index, "size", text, sizeof(text))) {
+            continue;
+        }
+        size_t size = parse_cache_size(text);
+        if (level == 1) {
+            caches->l1d = size;
+        } else if (level == 2) {
+            caches->l2 = size;
+        } else if (level == 3) {
+            caches->l3 = size;
+        }
+        if (caches->line == 0 &&
+            read_cache_attribute(index, "coherency_line_size", text, sizeof(text))) {
+            caches->line = (size_t)atoi(text);
+        }
+    }
+
+    caches_from_sysfs = caches->l1d > 0 && caches->l2 > 0;
+    if (caches->l1d == 0) {
+        caches->l1d = DEFAULT_L1D_SIZE;
+    }
+    if (caches->l2 == 0) {
+        caches->l2 = DEFAULT_L2_SIZE;
+    }
+    if (caches->line == 0) {
+        caches->line = DEFAULT_CACHE_LINE;
+    }
+}
+
+/**
+ * @brief Data cache sizes of the first CPU, read once from sysfs
+ * @param caches Receives the sizes; missing levels are filled with
+ *        defaults (32 KiB L1d, 256 KiB L2, 64-byte lines, no L3)
+ * @return true if the L1d and L2 sizes came from sysfs
+ */
+bool detect_cache_sizes(CacheSizes* caches) {
+    pthread_once(&caches_once, read_caches);
+    *caches = detected_caches;
+    return caches_from_sysfs;
+}
+
+/**
+ * @brief Block size and fan-in for sorting size elements
+ *
+ * A block and the scratch space its merge sort ping-pongs with fill the
+ * L2 cache. The fan-in is capped so each run keeps one line in half of
+ * L1d, then lowered to the smallest value needing the same number of
+ * passes, which keeps the tree shallow.
+ */
+static void plan_multiway(size_t size, const CacheSizes* caches, size_t* block, size_t* fan_in) {
+    *block = caches->l2 / (2 * sizeof(int));
+    if (*block < MULTIWAY_MIN_BLOCK) {
+        *block = MULTIWAY_MIN_BLOCK;
+    } else if (*block > MULTIWAY_MAX_BLOCK) {
+        *block = MULTIWAY_MAX_BLOCK;
+    }
+
+    size_t max_fan_in = caches->l1d / (2 * caches->line);
+    if (max_fan_in < 2) {
+        max_fan_in = 2;
+    } else if (max_fan_in > MULTIWAY_MAX_FAN_IN) {
+        max_fan_in = MULTIWAY_MAX_FAN_IN;
+    }
+
+    size_t runs = (size + *block - 1) / *block;
+    int passes = 0;
+    for (size_t remaining = runs; remaining > 1; remaining = (remaining + max_fan_in - 1) / max_fan_in) {
+        passes++;
+    }
+
+    // Smallest k with k^passes >= runs
+    *fan_in = 2;
+    for (;;) {
+        size_t reach = 1;
+        for (int p = 0; p < passes && reach < runs; p++) {
+            reach *= *fan_in;
+        }
+        if (reach >= runs || *fan_in >= max_fan_in) {
+            break;
+        }
+        (*fan_in)++;
+    }
+}
+
+/**
+ * @brief Pack a key and its run into one word ordered by (key, run)
+ */
+static inline uint64_t pack_head(int key, size_t run) {
+    return ((uint64_t)((uint32_t)key ^ 0x80000000u) << 32) | (uint64_t)run;
+}
+
+/**
+ * @brief Word of an exhausted run: above every (key, run) word, and
+ *        still naming its run
+ */
+static inline uint64_t exhausted_head(size_t run) {
+    return ((uint64_t)UINT32_MAX << 32) | MULTIWAY_EXHAUSTED_FLAG | (uint64_t)run;
+}
+
+static inline int head_key(uint64_t head) {
+    return (int)(int32_t)((uint32_t)(head >> 32) ^ 0x80000000u);
+}
+
+static inline size_t head_run(uint64_t head) {
+    return (size_t)(head & MULTIWAY_RUN_MASK);
+}
+
+/**
+ * @brief Scratch state of a k-way merge
+ */
+typedef struct {
+    uint64_t* tree;     /* tree[1..k): loser word of each match, tree[0]: winner */
+    uint64_t* winners;  /* 2k entries, used while the tree is built */
+    size_t* next;       /* next unread element of each run */
+    size_t* end;        /* end of each run */
+} LoserTreeScratch;
+
+/**
+ * @brief Merge k consecutive sorted runs of src[lo..hi) into dst[lo..hi)
+ *
+ * The tree holds packed (key, run) words rather than run indices, so a
+ * replay compares words without loading the runs' heads. Ties go to the
+ * lower run, so the merge is stable. Exhausted runs lose every match;
+ * exactly hi - lo winners are taken, so no end test is needed in the loop.
+ */
+static void merge_group(const int src[], int dst[], size_t lo, size_t hi, size_t run, size_t k,
+                        LoserTreeScratch* s) {
+    for (size_t i = 0; i < k; i++) {
+        size_t start = lo + i * run;
+        s->end[i] = start + run < hi ? start + run : hi;
+        s->next[i] = start + 1;
+        s->winners[k + i] = pack_head(src[start], i);
+    }
+
+    // Play the initial tournament bottom-up
+    for (size_t t = k - 1; t > 0; t--) {
+        uint64_t a = s->winners[2 * t];
+        uint64_t b = s->winners[2 * t + 1];
+        s->winners[t] = a < b ? a : b;
+        s->tree[t] = a < b ? b : a;
+    }
+    s->tree[0] = s->winners[1];
+
+    for (size_t out = lo; out < hi; out++) {
+        uint64_t head = s->tree[0];
+        size_t winner = head_run(head);
+        dst[out] = head_key(head);
+
+        size_t position = s->next[winner];
+        head = position < s->end[winner] ? pack_head(src[position], winner)
+                                         : exhausted_head(winner);
+        s->next[winner] = position + 1;
+
+        // Replay the matches on the path from the winner's leaf to the root;
+        // selects instead of branches, since the outcomes are unpredictable
+        for (size_t t = (winner + k) / 2; t > 0; t /= 2) {
+            uint64_t opponent = s->tree[t];
+            bool opponent_wins = opponent < head;
+            SORT_COUNT_COMPARISON();
+            s->tree[t] = opponent_wins ? head : opponent;
+            head = opponent_wins ? opponent : head;
+        }
+        s->tree[0] = head;
+    }
+    SORT_COUNT_PERMUTATIONS(hi - lo);
+}
+
+/**
+ * @brief One pass: merge every group of fan_in runs of length run
+ */
+static void merge_pass(const int src[], int dst[], size_t size, size_t run, size_t fan_in,
+                       LoserTreeScratch* scratch) {
+    for (size_t lo = 0; lo < size; lo += run * fan_in) {
+        size_t hi = size - lo > run * fan_in ? lo + run * fan_in : size;
+        size_t k = (hi - lo + run - 1) / run;
+        if (k == 1) {
+            memcpy(dst + lo, src + lo, (hi - lo) * sizeof(int));
+        } else {
+            merge_group(src, dst, lo, hi, run, k, scratch);
+        }
+    }
+    SORT_COUNT_BYTES(2 * size * sizeof(int));
+}
+
+/**
+ * @brief Cache-aware Multiway Merge Sort
+ *
+ * L2-sized blocks are sorted in cache. The sorted runs are then merged
+ * fan_in at a time through a loser tree, alternating between the array
+ * and one n-sized buffer. When the number of passes is odd, the blocks go
+ * to the buffer after sorting, so the last pass ends in the array. Stable.
+ * Time Complexity: O(n log n)
+ * Space Complexity: O(n)
+ * Memory traffic: O(n log_k(n / B)) for blocks of B elements and fan-in k
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @return false if memory could not be allocated (array unchanged)
+ */
+bool multiway_merge_sort(int arr[], size_t size) {
+    if (size < 2) {
+        return true;
+    }
+
+    CacheSizes caches;
+    size_t block, fan_in;
+    detect_cache_sizes(&caches);
+    plan_multiway(size, &caches, &block, &fan_in);
+
+    int* buffer = malloc(size * sizeof(int));
+    uint64_t* words = malloc(fan_in * 3 * sizeof(uint64_t));
+    size_t* positions = malloc(fan_in * 2 * sizeof(size_t));
+    if (buffer == NULL || words == NULL || positions == NULL) {
+        free(buffer);
+        free(words);
+        free(positions);
+        return false;
+    }
+    LoserTreeScratch scratch = { words, words + fan_in, positions, positions + fan_in };
+
+    int passes = 0;
+    for (size_t run = block; run < size; run *= fan_in) {
+        passes++;
+    }
+
+    // Sort each block in cache, using the matching part of the buffer
+    for (size_t lo = 0; lo < size; lo += block) {
+        size_t count = size - lo < block ? size - lo : block;
+        int32_merge_sort_with_buffer((int32_t*)arr + lo, count, (int32_t*)buffer + lo);
+        if (passes % 2 == 1) {
+            memcpy(buffer + lo, arr + lo, count * sizeof(int));
+        }
+    }
+    SORT_COUNT_BYTES(2 * size * sizeof(int));
+
+    int* src = passes % 2 == 1 ? buffer : arr;
+    int* dst = passes % 2 == 1 ? arr : buffer;
+    for (size_t run = block; run < size; run *= fan_in) {
+        merge_pass(src, dst, size, run, fan_in, &scratch);
+        SORT_TRACE_MESSAGE("Merged runs of %lu elements %lu at a time",
+                           (unsigned long)run, (unsigned long)fan_in);
+        int* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    free(buffer);
+    free(words);
+    free(positions);
+    return true;
+}
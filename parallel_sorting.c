@@ -0,0 +1,942 @@
+/**
+ * @file parallel_sorting.c
+ * @brief Parallel sorting algorithms built on the work-stealing pool
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * The parallel kernels do not update comparison_count/permutation_count
+ * (the counters are not thread-safe) and never report trace steps.
+ */
+
+#include "sorting_algorithms.h"
+
+/* Ranges at or below this size are sorted sequentially */
+#define PARALLEL_SORT_GRAIN 16384
+
+/* Merges producing at most this many elements run sequentially */
+#define PARALLEL_MERGE_GRAIN 16384
+
+typedef struct {
+    ThreadPool* pool;
+    int* a;
+    int* b;
+    size_t size;
+    bool into_b;
+} MergeSortTask;
+
+typedef struct {
+    ThreadPool* pool;
+    const int* left;
+    size_t left_size;
+    const int* right;
+    size_t right_size;
+    int* dst;
+} MergeTask;
+
+/**
+ * @brief Co-rank of an output position in a stable merge
+ *
+ * Returns i such that the first k elements of the stable merge of left
+ * and right are left[0..i) and right[0..k-i); on ties left elements come
+ * first. Found by binary search in O(log k).
+ * @param k Output position
+ * @param left First sorted input
+ * @param left_size Number of elements in left
+ * @param right Second sorted input
+ * @param right_size Number of elements in right
+ * @return Number of elements taken from left
+ */
+static size_t co_rank(size_t k, const int left[], size_t left_size,
+                      const int right[], size_t right_size) {
+    size_t lo = k > right_size ? k - right_size : 0;
+    size_t hi = k < left_size ? k : left_size;
+
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = k - i;
+        // left[i] belongs to the first k outputs if it does not exceed right[j-1]
+        if (j > 0 && left[i] <= right[j - 1]) {
+            lo = i + 1;
+        } else {
+            hi = i;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * @brief Sequential stable merge of two sorted inputs
+ */
+static void merge_sequential(const int left[], size_t left_size,
+                             const int right[], size_t right_size, int dst[]) {
+    size_t i = 0, j = 0, k = 0;
+
+    while (i < left_size && j < right_size) {
+        dst[k++] = (right[j] < left[i]) ? right[j++] : left[i++];
+    }
+    while (i < left_size) {
+        dst[k++] = left[i++];
+    }
+    while (j < right_size) {
+        dst[k++] = right[j++];
+    }
+}
+
+/**
+ * @brief Parallel merge: split both inputs at the co-rank of the middle
+ *        output position and merge the two halves concurrently
+ */
+static void parallel_merge_task(void* arg) {
+    const MergeTask* task = arg;
+    size_t total = task->left_size + task->right_size;
+
+    if (total <= PARALLEL_MERGE_GRAIN) {
+        merge_sequential(task->left, task->left_size, task->right, task->right_size, task->dst);
+        return;
+    }
+
+    size_t k = total / 2;
+    size_t i = co_rank(k, task->left, task->left_size, task->right, task->right_size);
+    size_t j = k - i;
+
+    MergeTask low = { task->pool, task->left, i, task->right, j, task->dst };
+    MergeTask high = { task->pool, task->left + i, task->left_size - i,
+                       task->right + j, task->right_size - j, task->dst + k };
+
+    TaskGroup group;
+    task_group_init(&group);
+    thread_pool_submit(task->pool, &group, parallel_merge_task, &low);
+    parallel_merge_task(&high);
+    thread_pool_wait(task->pool, &group);
+}
+
+/**
+ * @brief Sort task->a[0..size); the result lands in b if into_b is set,
+ *        otherwise in a (the other buffer is used as scratch)
+ */
+static void parallel_merge_sort_task(void* arg) {
+    const MergeSortTask* task = arg;
+
+    if (task->size <= PARALLEL_SORT_GRAIN) {
+        int32_merge_sort_with_buffer((int32_t*)task->a, task->size, (int32_t*)task->b);
+        if (task->into_b) {
+            memcpy(task->b, task->a, task->size * sizeof(int));
+        }
+        return;
+    }
+
+    // Sort both halves into the buffer we are not merging into
+    size_t half = task->size / 2;
+    MergeSortTask low = { task->pool, task->a, task->b, half, !task->into_b };
+    MergeSortTask high = { task->pool, task->a + half, task->b + half,
+                           task->size - half, !task->into_b };
+
+    TaskGroup group;
+    task_group_init(&group);
+    thread_pool_submit(task->pool, &group, parallel_merge_sort_task, &low);
+    parallel_merge_sort_task(&high);
+    thread_pool_wait(task->pool, &group);
+
+    const int* src = task->into_b ? task->a : task->b;
+    int* dst = task->into_b ? task->b : task->a;
+    MergeTask merge = { task->pool, src, half, src + half, task->size - half, dst };
+    parallel_merge_task(&merge);
+}
+
+/**
+ * @brief Parallel Merge Sort on an existing pool
+ *
+ * Recursion is split into tasks down to PARALLEL_SORT_GRAIN elements and
+ * each merge is itself split at co-ranks, so the top-level merge does
+ * not serialize. Stable; the output is identical to merge_sort().
+ * Time Complexity: O(n log n) work, O(log³ n) span
+ * Space Complexity: O(n)
+ * @param pool Pool executing the tasks
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param scratch Buffer of at least size elements
+ */
+void parallel_merge_sort_in_pool(ThreadPool* pool, int arr[], size_t size, int scratch[]) {
+    MergeSortTask task = { pool, arr, scratch, size, false };
+    parallel_merge_sort_task(&task);
+}
+
+/**
+ * @brief Parallel Merge Sort
+ *
+ * Allocates an n-element scratch buffer and a pool of `threads` threads
+ * (0 or less: one per online processor). Falls back to a sequential sort
+ * if the pool cannot be created.
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param threads Number of threads
+ * @return false if the scratch buffer could not be allocated (array unchanged)
+ */
+bool parallel_merge_sort(int arr[], size_t size, int threads) {
+    if (size < 2) {
+        return true;
+    }
+
+    int* scratch = malloc(size * sizeof(int));
+    if (scratch == NULL) {
+        return false;
+    }
+
+    if (threads <= 0) {
+        threads = thread_pool_default_threads();
+    }
+
+    ThreadPool* pool = (threads > 1 && size > PARALLEL_SORT_GRAIN) ? thread_pool_create(threads) : NULL;
+    if (pool != NULL) {
+        parallel_merge_sort_in_pool(pool, arr, size, scratch);
+        thread_pool_destroy(pool);
+    } else {
+        int32_merge_sort_with_buffer((int32_t*)arr, size, (int32_t*)scratch);
+    }
+
+    free(scratch);
+    return true;
+}
+
+/* Ranges at or below this size are finished by int32_quick_sort() */
+#define SAMPLE_SORT_BASE 512
+
+/* Average bucket size aimed for by steps with fewer than the maximum buckets */
+#define SAMPLE_SORT_BUCKET_TARGET 32
+
+/* Elements per block moved by the in-place permutation */
+#define SAMPLE_SORT_BLOCK 256
+
+/* Most buckets of one partitioning step (classification tree of depth 8) */
+#define SAMPLE_SORT_MAX_BUCKETS 256
+
+/* Upper bound of the oversampling factor */
+#define SAMPLE_SORT_MAX_OVERSAMPLING 16
+
+/* Fewest elements per stripe of a parallel classification */
+#define SAMPLE_SORT_MIN_STRIPE 65536
+
+/* Elements classified together so the tree descents overlap */
+#define SAMPLE_SORT_UNROLL 8
+
+/**
+ * @brief Splitters of one step, laid out for a branchless tree descent
+ */
+typedef struct {
+    int tree[SAMPLE_SORT_MAX_BUCKETS];  /* splitters in Eytzinger order, tree[1..leaves) */
+    int lower[SAMPLE_SORT_MAX_BUCKETS]; /* splitter just below each leaf (equality test) */
+    int log_leaves;
+    int leaves;
+    bool equal_buckets;                 /* bucket 2i-1 holds the keys equal to splitter i-1 */
+    int buckets;                        /* leaves, or 2 * leaves - 1 with equality buckets */
+} SampleClassifier;
+
+typedef struct SampleStep SampleStep;
+
+typedef struct {
+    SampleStep* step;
+    int index;
+} SamplePhaseTask;
+
+/**
+ * @brief Buffers of one sample sort driver, reused by every step it runs
+ */
+typedef struct {
+    int stripes;                /* stripes the buffers were sized for */
+    int buckets;                /* buckets per stripe the buffers were sized for */
+    int* buffers;               /* stripes x buckets x SAMPLE_SORT_BLOCK */
+    size_t* counts;             /* stripes x buckets: keys classified by each stripe */
+    size_t* stripe_ends;        /* end of the full blocks each stripe wrote back */
+    int* swap;                  /* stripes x 2 blocks used by the permutation */
+    SamplePhaseTask* tasks;
+} SampleWorkspace;
+
+/**
+ * @brief State of one partitioning step over arr[0..size)
+ *
+ * Block indices are relative to arr. Bucket b owns the block slots from
+ * its rounded-up start to the next bucket's; during the permutation its
+ * slots [write, read_end) still hold unprocessed blocks.
+ */
+struct SampleStep {
+    int* arr;
+    size_t size;
+    SampleClassifier classifier;
+    SampleWorkspace* workspace;
+    int stripes;
+    size_t stripe_size;
+    size_t starts[SAMPLE_SORT_MAX_BUCKETS + 1];
+    size_t write[SAMPLE_SORT_MAX_BUCKETS];
+    size_t read_end[SAMPLE_SORT_MAX_BUCKETS];
+    atomic_flag locks[SAMPLE_SORT_MAX_BUCKETS];
+    int overflow[SAMPLE_SORT_BLOCK];    /* block written past the end of arr */
+};
+
+typedef struct {
+    int* arr;
+    size_t size;
+    int levels;
+} SampleBucketTask;
+
+static int sample_floor_log2(size_t n) {
+    int log = 0;
+    while (n >>= 1) {
+        log++;
+    }
+    return log;
+}
+
+/**
+ * @brief Depth of the classification tree for a range of the given size
+ */
+static int sample_log_leaves(size_t size) {
+    int log_leaves = sample_floor_log2(size / SAMPLE_SORT_BUCKET_TARGET);
+    if (log_leaves < 1) {
+        return 1;
+    }
+    return log_leaves < 8 ? log_leaves : 8;
+}
+
+/**
+ * @brief Most buckets a step over a range of the given size can produce
+ */
+static int sample_max_buckets(size_t size) {
+    // Equality buckets at most double the leaves, within the 256 limit
+    int buckets = 2 << sample_log_leaves(size);
+    return buckets < SAMPLE_SORT_MAX_BUCKETS ? buckets : SAMPLE_SORT_MAX_BUCKETS;
+}
+
+static size_t round_up_block(size_t position) {
+    return (position + SAMPLE_SORT_BLOCK - 1) / SAMPLE_SORT_BLOCK * SAMPLE_SORT_BLOCK;
+}
+
+/**
+ * @brief Bucket of one key: log2(leaves) compare-and-shift steps, no branches
+ */
+static inline int sample_classify(const SampleClassifier* c, int x) {
+    int b = 1;
+    for (int level = 0; level < c->log_leaves; level++) {
+        b = 2 * b + (x >= c->tree[b]);
+    }
+    b -= c->leaves;
+    if (c->equal_buckets) {
+        b = 2 * b - (x == c->lower[b]);
+    }
+    return b;
+}
+
+/**
+ * @brief Buckets of SAMPLE_SORT_UNROLL consecutive keys, descending together
+ */
+static inline void sample_classify_batch(const SampleClassifier* c, const int x[], int out[]) {
+    int b[SAMPLE_SORT_UNROLL];
+
+    for (int u = 0; u < SAMPLE_SORT_UNROLL; u++) {
+        b[u] = 1;
+    }
+    for (int level = 0; level < c->log_leaves; level++) {
+        for (int u = 0; u < SAMPLE_SORT_UNROLL; u++) {
+            b[u] = 2 * b[u] + (x[u] >= c->tree[b[u]]);
+        }
+    }
+    for (int u = 0; u < SAMPLE_SORT_UNROLL; u++) {
+        out[u] = b[u] - c->leaves;
+        if (c->equal_buckets) {
+            out[u] = 2 * out[u] - (x[u] == c->lower[out[u]]);
+        }
+    }
+}
+
+/**
+ * @brief Store sorted splitters in-order into the implicit tree rooted at node
+ * @return Index of the next unused splitter
+ */
+static int fill_splitter_tree(int tree[], int node, int leaves, const int splitters[], int next) {
+    if (node >= leaves) {
+        return next;
+    }
+    next = fill_splitter_tree(tree, 2 * node, leaves, splitters, next);
+    tree[node] = splitters[next++];
+    return fill_splitter_tree(tree, 2 * node + 1, leaves, splitters, next);
+}
+
+/**
+ * @brief Draw an oversampled random sample and pick evenly spaced splitters
+ *
+ * Duplicate splitters mean some key is frequent: they are merged and every
+ * remaining splitter gets an equality bucket, whose keys are all equal and
+ * never need to be sorted again.
+ */
+static void build_classifier(SampleClassifier* c, const int arr[], size_t size, int log_leaves,
+                             uint64_t* seed) {
+    int oversampling = sample_floor_log2(size) / 5;
+    if (oversampling < 1) {
+        oversampling = 1;
+    } else if (oversampling > SAMPLE_SORT_MAX_OVERSAMPLING) {
+        oversampling = SAMPLE_SORT_MAX_OVERSAMPLING;
+    }
+
+    int leaves = 1 << log_leaves;
+    int sample_size = oversampling * leaves - 1;
+    int sample[SAMPLE_SORT_MAX_OVERSAMPLING * SAMPLE_SORT_MAX_BUCKETS];
+    for (int i = 0; i < sample_size; i++) {
+        *seed ^= *seed >> 12;
+        *seed ^= *seed << 25;
+        *seed ^= *seed >> 27;
+        sample[i] = arr[(*seed * 0x2545F4914F6CDD1DULL) % size];
+    }
+    int32_quick_sort((int32_t*)sample, (size_t)sample_size);
+
+    int splitters[SAMPLE_SORT_MAX_BUCKETS];
+    int count = 0;
+    bool duplicates = false;
+    for (int i = 1; i < leaves; i++) {
+        int splitter = sample[i * oversampling - 1];
+        if (count > 0 && splitter == splitters[count - 1]) {
+            duplicates = true;
+        } else {
+            splitters[count++] = splitter;
+        }
+    }
+
+    c->equal_buckets = duplicates;
+    if (duplicates) {
+        // Two buckets per leaf: keep at most SAMPLE_SORT_MAX_BUCKETS / 2 leaves
+        int kept = count < SAMPLE_SORT_MAX_BUCKETS / 2 ? count : SAMPLE_SORT_MAX_BUCKETS / 2 - 1;
+        for (int i = 0; i < kept; i++) {
+            splitters[i] = splitters[(size_t)i * (size_t)count / (size_t)kept];
+        }
+        count = kept;
+        for (log_leaves = 1; (1 << log_leaves) <= count; log_leaves++) {
+        }
+        leaves = 1 << log_leaves;
+        // Repeating the largest splitter only adds empty buckets
+        for (int i = count; i < leaves - 1; i++) {
+            splitters[i] = splitters[count - 1];
+        }
+    }
+
+    c->log_leaves = log_leaves;
+    c->leaves = leaves;
+    c->buckets = duplicates ? 2 * leaves - 1 : leaves;
+    fill_splitter_tree(c->tree, 1, leaves, splitters, 0);
+    // Keys of leaf 0 are below splitters[0], so its equality test never fires
+    c->lower[0] = splitters[0];
+    for (int i = 1; i < leaves; i++) {
+        c->lower[i] = splitters[i - 1];
+    }
+}
+
+static void sample_lock(SampleStep* step, int bucket) {
+    while (atomic_flag_test_and_set_explicit(&step->locks[bucket], memory_order_acquire)) {
+    }
+}
+
+static void sample_unlock(SampleStep* step, int bucket) {
+    atomic_flag_clear_explicit(&step->locks[bucket], memory_order_release);
+}
+
+/**
+ * @brief Phase 1: classify one stripe into its bucket buffers
+ *
+ * Every time a buffer fills up it is written back as a block at the front
+ * of the stripe, which never overtakes the keys still to be read.
+ */
+static void classify_stripe_task(void* arg) {
+    const SamplePhaseTask* task = arg;
+    SampleStep* step = task->step;
+    const SampleClassifier* c = &step->classifier;
+    int* arr = step->arr;
+    size_t begin = (size_t)task->index * step->stripe_size;
+    size_t end = begin + step->stripe_size < step->size ? begin + step->stripe_size : step->size;
+    int* buffers = step->workspace->buffers + (size_t)task->index * c->buckets * SAMPLE_SORT_BLOCK;
+    size_t* counts = step->workspace->counts + (size_t)task->index * c->buckets;
+    size_t write = begin;
+    size_t i = begin;
+
+    memset(counts, 0, (size_t)c->buckets * sizeof(size_t));
+
+#define SAMPLE_PUSH(key, bucket)                                                        \
+    do {                                                                                \
+        int* buffer_ = buffers + (size_t)(bucket) * SAMPLE_SORT_BLOCK;                  \
+        buffer_[counts[bucket] % SAMPLE_SORT_BLOCK] = (key);                            \
+        if (++counts[bucket] % SAMPLE_SORT_BLOCK == 0) {                                \
+            memcpy(arr + write, buffer_, SAMPLE_SORT_BLOCK * sizeof(int));              \
+            write += SAMPLE_SORT_BLOCK;                                                 \
+        }                                                                               \
+    } while (0)
+
+    for (; i + SAMPLE_SORT_UNROLL <= end; i += SAMPLE_SORT_UNROLL) {
+        int buckets[SAMPLE_SORT_UNROLL];
+        sample_classify_batch(c, arr + i, buckets);
+        for (int u = 0; u < SAMPLE_SORT_UNROLL; u++) {
+            SAMPLE_PUSH(arr[i + u], buckets[u]);
+        }
+    }
+    for (; i < end; i++) {
+        SAMPLE_PUSH(arr[i], sample_classify(c, arr[i]));
+    }
+
+#undef SAMPLE_PUSH
+
+    step->workspace->stripe_ends[task->index] = write;
+}
+
+/**
+ * @brief Whether a block slot holds a full block after phase 1
+ */
+static bool block_is_full(const SampleStep* step, size_t block) {
+    size_t position = block * SAMPLE_SORT_BLOCK;
+    if (position + SAMPLE_SORT_BLOCK > step->size) {
+        return false;
+    }
+    return position + SAMPLE_SORT_BLOCK <= step->workspace->stripe_ends[position / step->stripe_size];
+}
+
+/**
+ * @brief Phase 2: move the full blocks of each bucket's slots to their front
+ *
+ * Task i handles buckets i, i + stripes, ...; the slot ranges are disjoint.
+ */
+static void compact_buckets_task(void* arg) {
+    const SamplePhaseTask* task = arg;
+    SampleStep* step = task->step;
+
+    for (int b = task->index; b < step->classifier.buckets; b += step->stripes) {
+        size_t first = round_up_block(step->starts[b]) / SAMPLE_SORT_BLOCK;
+        size_t last = round_up_block(step->starts[b + 1]) / SAMPLE_SORT_BLOCK;
+        size_t full = 0;
+
+        for (size_t block = first; block < last; block++) {
+            full += block_is_full(step, block);
+        }
+
+        // Fill empty slots near the front with full blocks from the back
+        size_t empty = first, source = last;
+        for (;;) {
+            while (empty < source && block_is_full(step, empty)) {
+                empty++;
+            }
+            while (source > empty && !block_is_full(step, source - 1)) {
+                source--;
+            }
+            if (source <= empty) {
+                break;
+            }
+            memcpy(step->arr + empty * SAMPLE_SORT_BLOCK,
+                   step->arr + (source - 1) * SAMPLE_SORT_BLOCK, SAMPLE_SORT_BLOCK * sizeof(int));
+            empty++;
+            source--;
+        }
+
+        step->write[b] = first;
+        step->read_end[b] = first + full;
+    }
+}
+
+/**
+ * @brief Take the last unprocessed block of a bucket
+ * @return false if the bucket has none left
+ */
+static bool read_block(SampleStep* step, int bucket, int block[]) {
+    bool found = false;
+
+    sample_lock(step, bucket);
+    if (step->write[bucket] < step->read_end[bucket]) {
+        step->read_end[bucket]--;
+        memcpy(block, step->arr + step->read_end[bucket] * SAMPLE_SORT_BLOCK,
+               SAMPLE_SORT_BLOCK * sizeof(int));
+        found = true;
+    }
+    sample_unlock(step, bucket);
+
+    return found;
+}
+
+/**
+ * @brief Put a block into the next slot of its bucket
+ *
+ * Unprocessed blocks that already belong to the bucket are skipped. If
+ * the slot still holds an unprocessed block, that block is swapped out
+ * into displaced.
+ * @return true if a block was displaced and must be placed next
+ */
+static bool write_block(SampleStep* step, int bucket, const int block[], int displaced[]) {
+    bool swapped = false;
+
+    sample_lock(step, bucket);
+    size_t slot = step->write[bucket];
+    while (slot < step->read_end[bucket] &&
+           sample_classify(&step->classifier, step->arr[slot * SAMPLE_SORT_BLOCK]) == bucket) {
+        slot++;
+    }
+    step->write[bucket] = slot + 1;
+
+    int* target = step->arr + slot * SAMPLE_SORT_BLOCK;
+    if (slot < step->read_end[bucket]) {
+        memcpy(displaced, target, SAMPLE_SORT_BLOCK * sizeof(int));
+        swapped = true;
+    } else if ((slot + 1) * SAMPLE_SORT_BLOCK > step->size) {
+        // Only the last slot of the last non-empty bucket can pass the end
+        target = step->overflow;
+    }
+    memcpy(target, block, SAMPLE_SORT_BLOCK * sizeof(int));
+    sample_unlock(step, bucket);
+
+    return swapped;
+}
+
+/**
+ * @brief Phase 3: move every block to a slot of its bucket
+ *
+ * Task i starts reading at its own bucket and then visits the others, so
+ * the tasks rarely contend for a bucket lock; a task that finds no
+ * unprocessed block left anywhere is done.
+ */
+static void permute_blocks_task(void* arg) {
+    const SamplePhaseTask* task = arg;
+    SampleStep* step = task->step;
+    int buckets = step->classifier.buckets;
+    int* current = step->workspace->swap + (size_t)task->index * 2 * SAMPLE_SORT_BLOCK;
+    int* displaced = current + SAMPLE_SORT_BLOCK;
+    int primary = (int)((long)task->index * buckets / step->stripes);
+
+    for (int pass = 0; pass < buckets; pass++) {
+        int bucket = (primary + pass) % buckets;
+        while (read_block(step, bucket, current)) {
+            while (write_block(step, sample_classify(&step->classifier, current[0]),
+                               current, displaced)) {
+                int* next = displaced;
+                displaced = current;
+                current = next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Destination ranges of the keys a bucket still has to place
+ */
+typedef struct {
+    size_t position[2];
+    size_t end[2];
+    int current;
+} SampleGaps;
+
+static void fill_gaps(int arr[], SampleGaps* gaps, const int keys[], size_t count) {
+    while (count > 0) {
+        size_t room = gaps->end[gaps->current] - gaps->position[gaps->current];
+        if (room == 0) {
+            gaps->current++;
+            continue;
+        }
+        size_t chunk = count < room ? count : room;
+        memcpy(arr + gaps->position[gaps->current], keys, chunk * sizeof(int));
+        gaps->position[gaps->current] += chunk;
+        keys += chunk;
+        count -= chunk;
+    }
+}
+
+/**
+ * @brief Phase 4: place the partial blocks left in the stripe buffers
+ *
+ * Bucket b's full blocks now start at its rounded-up start. The keys in
+ * front of them (in the previous bucket's last slot) and after them up to
+ * the bucket's end are filled from the buffers; the part of the last
+ * block that spills into the next bucket is moved the same way. Buckets
+ * are handled in order, so a spill is read before the next bucket
+ * overwrites it.
+ */
+static void place_partial_blocks(SampleStep* step) {
+    int* arr = step->arr;
+    const SampleWorkspace* workspace = step->workspace;
+    int buckets = step->classifier.buckets;
+    int spill[SAMPLE_SORT_BLOCK];
+
+    for (int b = 0; b < buckets; b++) {
+        size_t start = step->starts[b];
+        size_t end = step->starts[b + 1];
+        size_t blocks_start = round_up_block(start);
+        size_t blocks_end = step->write[b] * SAMPLE_SORT_BLOCK;
+        size_t spilled = 0;
+        SampleGaps gaps = { { start, end }, { end, end }, 0 };
+
+        if (blocks_end > blocks_start) {
+            gaps.end[0] = blocks_start;
+            if (blocks_end < end) {
+                gaps.position[1] = blocks_end;
+            } else {
+                spilled = blocks_end - end;
+            }
+        }
+
+        if (spilled > 0) {
+            if (blocks_end > step->size) {
+                size_t slot = blocks_end - SAMPLE_SORT_BLOCK;
+                memcpy(arr + slot, step->overflow, (step->size - slot) * sizeof(int));
+                memcpy(spill, arr + end, (step->size - end) * sizeof(int));
+                memcpy(spill + (step->size - end), step->overflow + (step->size - slot),
+                       (blocks_end - step->size) * sizeof(int));
+            } else {
+                memcpy(spill, arr + end, spilled * sizeof(int));
+            }
+            fill_gaps(arr, &gaps, spill, spilled);
+        }
+
+        for (int s = 0; s < step->stripes; s++) {
+            size_t index = (size_t)s * buckets + b;
+            fill_gaps(arr, &gaps, workspace->buffers + index * SAMPLE_SORT_BLOCK,
+                      workspace->counts[index] % SAMPLE_SORT_BLOCK);
+        }
+    }
+}
+
+/**
+ * @brief Run one task per stripe, on the pool if there is one
+ */
+static void run_sample_phase(ThreadPool* pool, SampleStep* step, void (*phase)(void* arg)) {
+    SamplePhaseTask* tasks = step->workspace->tasks;
+
+    for (int i = 0; i < step->stripes; i++) {
+        tasks[i].step = step;
+        tasks[i].index = i;
+    }
+    if (pool == NULL || step->stripes == 1) {
+        for (int i = 0; i < step->stripes; i++) {
+            phase(&tasks[i]);
+        }
+        return;
+    }
+
+    TaskGroup group;
+    task_group_init(&group);
+    for (int i = 1; i < step->stripes; i++) {
+        thread_pool_submit(pool, &group, phase, &tasks[i]);
+    }
+    phase(&tasks[0]);
+    thread_pool_wait(pool, &group);
+}
+
+/**
+ * @brief Partition arr[0..size) into the buckets of a sampled classifier
+ *
+ * Afterwards bucket b occupies arr[step->starts[b]..step->starts[b+1]).
+ * @param stripes Number of stripes classified concurrently (1: sequential)
+ */
+static void sample_sort_step(SampleStep* step, ThreadPool* pool, SampleWorkspace* workspace,
+                             int arr[], size_t size, int stripes) {
+    step->arr = arr;
+    step->size = size;
+    step->workspace = workspace;
+
+    uint64_t seed = (uint64_t)size * 0x9E3779B97F4A7C15ULL | 1;
+    build_classifier(&step->classifier, arr, size, sample_log_leaves(size), &seed);
+    int buckets = step->classifier.buckets;
+
+    // Stripes start on block boundaries
+    step->stripe_size = round_up_block((size + (size_t)stripes - 1) / (size_t)stripes);
+    step->stripes = (int)((size + step->stripe_size - 1) / step->stripe_size);
+    run_sample_phase(pool, step, classify_stripe_task);
+
+    size_t total = 0;
+    for (int b = 0; b < buckets; b++) {
+        step->starts[b] = total;
+        for (int s = 0; s < step->stripes; s++) {
+            total += workspace->counts[(size_t)s * buckets + b];
+        }
+        atomic_flag_clear(&step->locks[b]);
+    }
+    step->starts[buckets] = total;
+
+    run_sample_phase(pool, step, compact_buckets_task);
+    run_sample_phase(pool, step, permute_blocks_task);
+    place_partial_blocks(step);
+}
+
+static void free_sample_workspace(SampleWorkspace* workspace) {
+    free(workspace->buffers);
+    free(workspace->counts);
+    free(workspace->stripe_ends);
+    free(workspace->swap);
+    free(workspace->tasks);
+}
+
+/**
+ * @brief Allocate the buffers for up to `stripes` concurrent stripes over
+ *        a range of at most `size` keys
+ * @return false if memory could not be allocated
+ */
+static bool init_sample_workspace(SampleWorkspace* workspace, int stripes, size_t size) {
+    workspace->buckets = sample_max_buckets(size);
+    size_t slots = (size_t)stripes * (size_t)workspace->buckets;
+
+    workspace->stripes = stripes;
+    workspace->buffers = malloc(slots * SAMPLE_SORT_BLOCK * sizeof(int));
+    workspace->counts = malloc(slots * sizeof(size_t));
+    workspace->stripe_ends = malloc((size_t)stripes * sizeof(size_t));
+    workspace->swap = malloc((size_t)stripes * 2 * SAMPLE_SORT_BLOCK * sizeof(int));
+    workspace->tasks = malloc((size_t)stripes * sizeof(SamplePhaseTask));
+    if (workspace->buffers == NULL || workspace->counts == NULL ||
+        workspace->stripe_ends == NULL || workspace->swap == NULL || workspace->tasks == NULL) {
+        free_sample_workspace(workspace);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Whether bucket b of a step still needs sorting
+ */
+static bool bucket_needs_sort(const SampleStep* step, int b) {
+    bool equal_keys = step->classifier.equal_buckets && (b & 1);
+    return !equal_keys && step->starts[b + 1] - step->starts[b] > 1;
+}
+
+/**
+ * @brief Sequential in-place sample sort
+ * @param levels Steps left before falling back to introsort (bounds the
+ *        work if the samples keep producing one huge bucket)
+ */
+static void sample_sort_sequential(SampleWorkspace* workspace, int arr[], size_t size, int levels) {
+    if (size <= SAMPLE_SORT_BASE || levels == 0) {
+        int32_quick_sort((int32_t*)arr, size);
+        return;
+    }
+
+    SampleStep step;
+    sample_sort_step(&step, NULL, workspace, arr, size, 1);
+    for (int b = 0; b < step.classifier.buckets; b++) {
+        if (bucket_needs_sort(&step, b)) {
+            sample_sort_sequential(workspace, arr + step.starts[b],
+                                   step.starts[b + 1] - step.starts[b], levels - 1);
+        }
+    }
+}
+
+/**
+ * @brief Sort one bucket on whichever thread picked the task up
+ */
+static void sample_bucket_task(void* arg) {
+    const SampleBucketTask* task = arg;
+    SampleWorkspace workspace;
+
+    if (task->size <= SAMPLE_SORT_BASE || !init_sample_workspace(&workspace, 1, task->size)) {
+        int32_quick_sort((int32_t*)task->arr, task->size);
+        return;
+    }
+    sample_sort_sequential(&workspace, task->arr, task->size, task->levels);
+    free_sample_workspace(&workspace);
+}
+
+/**
+ * @brief One parallel step, then the buckets
+ *
+ * Buckets larger than large_bucket get another parallel step from this
+ * thread; all others become pool tasks, which idle threads steal as they
+ * finish, so uneven buckets balance out dynamically.
+ */
+static void sample_sort_parallel(ThreadPool* pool, SampleWorkspace* workspace, int arr[],
+                                 size_t size, int levels, size_t large_bucket) {
+    size_t stripes = size / SAMPLE_SORT_MIN_STRIPE;
+    if (stripes > (size_t)workspace->stripes) {
+        stripes = (size_t)workspace->stripes;
+    }
+    if (stripes < 2 || levels == 0) {
+        sample_sort_sequential(workspace, arr, size, levels);
+        return;
+    }
+
+    SampleStep step;
+    SampleBucketTask tasks[SAMPLE_SORT_MAX_BUCKETS];
+    TaskGroup group;
+    sample_sort_step(&step, pool, workspace, arr, size, (int)stripes);
+
+    task_group_init(&group);
+    for (int b = 0; b < step.classifier.buckets; b++) {
+        size_t bucket_size = step.starts[b + 1] - step.starts[b];
+        if (bucket_needs_sort(&step, b) && bucket_size <= large_bucket) {
+            tasks[b].arr = arr + step.starts[b];
+            tasks[b].size = bucket_size;
+            tasks[b].levels = levels - 1;
+            thread_pool_submit(pool, &group, sample_bucket_task, &tasks[b]);
+        }
+    }
+    for (int b = 0; b < step.classifier.buckets; b++) {
+        size_t bucket_size = step.starts[b + 1] - step.starts[b];
+        if (bucket_needs_sort(&step, b) && bucket_size > large_bucket) {
+            sample_sort_parallel(pool, workspace, arr + step.starts[b], bucket_size,
+                                 levels - 1, large_bucket);
+        }
+    }
+    thread_pool_wait(pool, &group);
+}
+
+/**
+ * @brief In-place Parallel Sample Sort on an existing pool (IPS4o style)
+ *
+ * Each step classifies the keys into up to 256 buckets with a branchless
+ * search tree over oversampled splitters. Every thread collects its
+ * stripe's keys in per-bucket buffers and writes full blocks back in
+ * place; the blocks are then permuted into their buckets by all threads
+ * under per-bucket locks, and the partial blocks fill the gaps. Frequent
+ * keys get equality buckets that are never sorted again.
+ * Time Complexity: O(n log n) expected work
+ * Space Complexity: O(t * 256 * SAMPLE_SORT_BLOCK) buffers, O(log n) stack;
+ *                   independent of n
+ * @param pool Pool executing the tasks (NULL: sequential)
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @return false if the buffers could not be allocated (array unchanged)
+ */
+bool parallel_sample_sort_in_pool(ThreadPool* pool, int arr[], size_t size) {
+    if (size <= SAMPLE_SORT_BASE) {
+        int32_quick_sort((int32_t*)arr, size);
+        return true;
+    }
+
+    int threads = pool != NULL ? thread_pool_size(pool) : 1;
+    SampleWorkspace workspace;
+    if (!init_sample_workspace(&workspace, threads, size)) {
+        return false;
+    }
+
+    int levels = sample_floor_log2(size);
+    if (pool == NULL || threads == 1) {
+        sample_sort_sequential(&workspace, arr, size, levels);
+    } else {
+        sample_sort_parallel(pool, &workspace, arr, size, levels, size / (size_t)threads);
+    }
+
+    free_sample_workspace(&workspace);
+    return true;
+}
+
+/**
+ * @brief In-place Parallel Sample Sort
+ *
+ * Creates a pool of `threads` threads (0 or less: one per online
+ * processor) and sorts without an n-sized buffer; see
+ * parallel_sample_sort_in_pool(). Runs sequentially if the pool cannot be
+ * created. Not stable.
+ * @param arr Array to sort
+ * @param size Size of the array
+ * @param threads Number of threads
+ * @return false if the buffers could not be allocated (array unchanged)
+ */
+bool parallel_sample_sort(int arr[], size_t size, int threads) {
+    if (size < 2) {
+        return true;
+    }
+
+    if (threads <= 0) {
+        threads = thread_pool_default_threads();
+    }
+
+    ThreadPool* pool = (threads > 1 && size > 2 * SAMPLE_SORT_MIN_STRIPE) ? thread_pool_create(threads) : NULL;
+    bool sorted = parallel_sample_sort_in_pool(pool, arr, size);
+    thread_pool_destroy(pool);
+
+    return sorted;
+}
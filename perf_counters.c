@@ -0,0 +1,208 @@
+/**
+ * @file perf_counters.c
+ * @brief Hardware performance counters around sort calls (Linux perf_event_open)
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Each event is opened as its own counter on the calling thread, user
+ * space only, and left disabled until perf_counters_start(). Events the
+ * kernel or the CPU does not provide (containers, virtual machines,
+ * kernel.perf_event_paranoid > 2) are simply reported as unavailable;
+ * the sort itself is never affected.
+ *
+ * Work done by thread pool workers is not included in the counts.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include "sorting_algorithms.h"
+#include <errno.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* const event_names[PERF_EVENT_COUNT] = {
+    "cycles",
+    "instructions",
+    "L1D misses",
+    "LLC misses",
+    "branch misses"
+};
+
+#ifdef __linux__
+/**
+ * @brief perf_event_open(2) type and config of each event
+ */
+static const struct {
+    uint32_t type;
+    uint64_t config;
+} event_configs[PERF_EVENT_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                          (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+};
+
+/**
+ * @brief Open one disabled user-space counter on the calling thread
+ * @return File descriptor, or -1 with errno set
+ */
+static int open_event(PerfEvent event) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event_configs[event].type;
+    attr.config = event_configs[event].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Enabled/running times let the counts be scaled when the PMU multiplexes
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Read a counter, scaled up if it only ran for part of the window
+ */
+static uint64_t read_event(int fd) {
+    uint64_t data[3]; /* value, time enabled, time running */
+
+    if (read(fd, data, sizeof(data)) != (ssize_t)sizeof(data) || data[2] == 0) {
+        return 0;
+    }
+    if (data[2] < data[1]) {
+        return (uint64_t)((double)data[0] * (double)data[1] / (double)data[2]);
+    }
+    return data[0];
+}
+#endif
+
+/**
+ * @brief Open every hardware event on the calling thread
+ * @param counters Counter set to initialize (always safe to close)
+ * @return true if at least one event is available
+ */
+bool perf_counters_open(PerfCounters* counters) {
+    bool any = false;
+
+    counters->error = 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        counters->values[e] = 0;
+#ifdef __linux__
+        counters->fds[e] = open_event((PerfEvent)e);
+        if (counters->fds[e] < 0 && counters->error == 0) {
+            counters->error = errno;
+        }
+#else
+        counters->fds[e] = -1;
+        counters->error = ENOSYS;
+#endif
+        any = any || counters->fds[e] >= 0;
+    }
+
+    return any;
+}
+
+/**
+ * @brief Reset the available counters and start counting
+ * @param counters Opened counter set
+ */
+void perf_counters_start(PerfCounters* counters) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0) {
+            ioctl(counters->fds[e], PERF_EVENT_IOC_RESET, 0);
+        }
+    }
+    // Enabled back to back so the window is the same for every event
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0) {
+            ioctl(counters->fds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+/**
+ * @brief Stop counting and store the counts of the window in values[]
+ * @param counters Started counter set
+ */
+void perf_counters_stop(PerfCounters* counters) {
+#ifdef __linux__
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0) {
+            ioctl(counters->fds[e], PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        counters->values[e] = counters->fds[e] >= 0 ? read_event(counters->fds[e]) : 0;
+    }
+#else
+    (void)counters;
+#endif
+}
+
+/**
+ * @brief Release the counters (values[] are kept)
+ * @param counters Counter set to close
+ */
+void perf_counters_close(PerfCounters* counters) {
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+#ifdef __linux__
+        if (counters->fds[e] >= 0) {
+            close(counters->fds[e]);
+        }
+#endif
+        counters->fds[e] = -1;
+    }
+}
+
+/**
+ * @brief Whether an event could be opened
+ */
+bool perf_counter_available(const PerfCounters* counters, PerfEvent event) {
+    return counters->fds[event] >= 0;
+}
+
+/**
+ * @brief Human-readable name of an event
+ */
+const char* perf_event_name(PerfEvent event) {
+    return event_names[event];
+}
+
+/**
+ * @brief Print the counts of the last window, in the style of print_statistics()
+ * @param counters Stopped counter set
+ */
+void print_perf_counters(const PerfCounters* counters) {
+    printf("\n=== Hardware Counters ===\n");
+    for (int e = 0; e < PERF_EVENT_COUNT; e++) {
+        if (counters->fds[e] >= 0) {
+            printf("%-14s %llu\n", event_names[e], (unsigned long long)counters->values[e]);
+        } else {
+            printf("%-14s n/a\n", event_names[e]);
+        }
+    }
+
+    uint64_t cycles = counters->values[PERF_EVENT_CYCLES];
+    if (perf_counter_available(counters, PERF_EVENT_CYCLES) &&
+        perf_counter_available(counters, PERF_EVENT_INSTRUCTIONS) && cycles > 0) {
+        printf("%-14s %.2f\n", "IPC",
+               (double)counters->values[PERF_EVENT_INSTRUCTIONS] / (double)cycles);
+    }
+    if (counters->error != 0) {
+        printf("(some events unavailable: %s)\n", strerror(counters->error));
+    }
+    printf("=========================\n");
+}
@@ -0,0 +1,238 @@
+/**
+ * @file segmented_sorting.c
+ * @brief Segmented (batched) sort of many small independent arrays
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * The segments live back to back in one flat buffer, described by an
+ * offsets array in the usual compressed layout: segment i is
+ * data[offsets[i]..offsets[i + 1]). Each segment is sorted by the kernel
+ * that suits its length. Below 8 keys that is insertion sort, since
+ * padding to the smallest network costs more. Up to 64 keys it is the
+ * vector sorting network. Longer segments use an introsort whose
+ * partitions are finished by the network. Without a vector network,
+ * insertion sort and int32_quick_sort() split the range. No kernel
+ * allocates. With threads, the segments are cut into chunks of about
+ * equal element counts, and pool workers take the chunks as tasks.
+ *
+ * Like the other parallel kernels, this does not update the operation
+ * counters or report trace steps.
+ */
+
+#include "sorting_algorithms.h"
+
+/* Shortest segment worth padding to the 8-key network */
+#define SEGMENT_NETWORK_MIN 8
+
+/* Segments up to this length use insertion sort when there is no vector network */
+#define SEGMENT_INSERTION_MAX 32
+
+/* Elements per pool task; small enough for every thread to get work */
+#define SEGMENT_TASK_GRAIN 16384
+
+/* Chunks per thread, so uneven chunks still balance */
+#define SEGMENT_TASKS_PER_THREAD 4
+
+/**
+ * @brief Length limits of the kernels, fixed for one call
+ */
+typedef struct {
+    size_t insertion_max;   /* longest segment for insertion sort */
+    size_t network_max;     /* longest for the vector network, 0 without one */
+} SegmentKernels;
+
+typedef struct {
+    int* data;
+    const size_t* offsets;
+    size_t first;   /* first segment of the chunk */
+    size_t last;    /* one past the last segment */
+    SegmentKernels kernels;
+} SegmentChunk;
+
+static SegmentKernels choose_kernels(void) {
+    SegmentKernels kernels;
+    bool network = simd_leaf_size() > 0;
+    kernels.insertion_max = network ? SEGMENT_NETWORK_MIN - 1 : SEGMENT_INSERTION_MAX;
+    kernels.network_max = network ? SIMD_SORT_MAX_BLOCK : 0;
+    return kernels;
+}
+
+static inline void swap_keys(int32_t* a, int32_t* b) {
+    int32_t temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+/**
+ * @brief Hoare partition around the median of the first, middle and last keys
+ * @return Cut c with arr[0..c) <= pivot <= arr[c..size), 0 < c < size
+ */
+static size_t partition_segment(int32_t arr[], size_t size) {
+    size_t mid = size / 2;
+    if (arr[mid] < arr[0]) {
+        swap_keys(&arr[mid], &arr[0]);
+    }
+    if (arr[size - 1] < arr[mid]) {
+        swap_keys(&arr[size - 1], &arr[mid]);
+        if (arr[mid] < arr[0]) {
+            swap_keys(&arr[mid], &arr[0]);
+        }
+    }
+
+    // arr[0] and arr[size - 1] stop the scans, so they need no bounds checks
+    int32_t pivot = arr[mid];
+    size_t i = 0;
+    size_t j = size - 1;
+    for (;;) {
+        while (arr[++i] < pivot) {
+        }
+        while (pivot < arr[--j]) {
+        }
+        if (i >= j) {
+            return i;
+        }
+        swap_keys(&arr[i], &arr[j]);
+    }
+}
+
+/**
+ * @brief Introsort that leaves every part of at most SIMD_SORT_MAX_BLOCK
+ *        keys to the sorting network (heap sort past the depth limit)
+ */
+static void network_introsort(int32_t arr[], size_t size, int depth) {
+    while (size > SIMD_SORT_MAX_BLOCK) {
+        if (depth-- == 0) {
+            int32_heap_sort(arr, size);
+            return;
+        }
+        size_t cut = partition_segment(arr, size);
+        // Recurse into the smaller part so the stack stays O(log n)
+        if (cut < size - cut) {
+            network_introsort(arr, cut, depth);
+            arr += cut;
+            size -= cut;
+        } else {
+            network_introsort(arr + cut, size - cut, depth);
+            size = cut;
+        }
+    }
+    simd_sort_block(arr, size);
+}
+
+/**
+ * @brief Sort segments [first, last) one after another
+ */
+static void sort_segments(int data[], const size_t offsets[], size_t first, size_t last,
+                          SegmentKernels kernels) {
+    for (size_t s = first; s < last; s++) {
+        int32_t* segment = (int32_t*)data + offsets[s];
+        size_t length = offsets[s + 1] - offsets[s];
+        if (length <= kernels.insertion_max) {
+            int32_insertion_sort(segment, length);
+        } else if (length <= kernels.network_max) {
+            simd_sort_block(segment, length);
+        } else if (kernels.network_max > 0) {
+            int depth = 0;
+            for (size_t n = length; n > 1; n /= 2) {
+                depth += 2;
+            }
+            network_introsort(segment, length, depth);
+        } else {
+            int32_quick_sort(segment, length);
+        }
+    }
+}
+
+static void segment_chunk_task(void* arg) {
+    SegmentChunk* chunk = arg;
+    sort_segments(chunk->data, chunk->offsets, chunk->first, chunk->last, chunk->kernels);
+}
+
+/**
+ * @brief Segmented sort on an existing pool
+ *
+ * Falls back to one sequential pass when the pool is NULL, the data is
+ * too small to split, or the chunk list cannot be allocated.
+ * @param pool Thread pool, or NULL
+ * @param data Flat buffer holding every segment
+ * @param offsets segment_count + 1 non-decreasing offsets into data
+ * @param segment_count Number of segments
+ */
+void segmented_sort_in_pool(ThreadPool* pool, int data[], const size_t offsets[],
+                            size_t segment_count) {
+    SegmentKernels kernels = choose_kernels();
+    size_t total = offsets[segment_count] - offsets[0];
+    size_t tasks = 0;
+    if (pool != NULL) {
+        tasks = (size_t)thread_pool_size(pool) * SEGMENT_TASKS_PER_THREAD;
+        if (tasks > total / SEGMENT_TASK_GRAIN) {
+            tasks = total / SEGMENT_TASK_GRAIN;
+        }
+        if (tasks > segment_count) {
+            tasks = segment_count;
+        }
+    }
+
+    SegmentChunk* chunks = tasks > 1 ? malloc(tasks * sizeof(SegmentChunk)) : NULL;
+    if (chunks == NULL) {
+        sort_segments(data, offsets, 0, segment_count, kernels);
+        return;
+    }
+
+    // Cut after the segment that crosses each multiple of total / tasks
+    TaskGroup group;
+    task_group_init(&group);
+    size_t first = 0;
+    size_t used = 0;
+    for (size_t t = 0; t < tasks && first < segment_count; t++) {
+        size_t last = segment_count;
+        if (t + 1 < tasks) {
+            size_t target = offsets[0] + total / tasks * (t + 1);
+            last = first + 1;
+            while (last < segment_count && offsets[last] < target) {
+                last++;
+            }
+        }
+        chunks[used] = (SegmentChunk){ data, offsets, first, last, kernels };
+        thread_pool_submit(pool, &group, segment_chunk_task, &chunks[used]);
+        used++;
+        first = last;
+    }
+    thread_pool_wait(pool, &group);
+
+    free(chunks);
+}
+
+/**
+ * @brief Sort many independent segments of one flat buffer in one call
+ *
+ * Segment i is data[offsets[i]..offsets[i + 1]). Each segment gets the
+ * kernel that suits its length (insertion sort, sorting network or
+ * introsort, see the file comment). Not stable (irrelevant for plain
+ * integers).
+ * Time Complexity: O(sum of l log l) over segment lengths l
+ * Space Complexity: O(1), plus O(threads) with threads
+ * @param data Flat buffer holding every segment
+ * @param offsets segment_count + 1 offsets into data
+ * @param segment_count Number of segments
+ * @param threads Worker threads (<= 0: every online CPU, 1: sequential)
+ * @return false if the offsets decrease (data unchanged)
+ */
+bool segmented_sort(int data[], const size_t offsets[], size_t segment_count, int threads) {
+    for (size_t s = 0; s < segment_count; s++) {
+        if (offsets[s + 1] < offsets[s]) {
+            return false;
+        }
+    }
+
+    if (threads <= 0) {
+        threads = thread_pool_default_threads();
+    }
+
+    size_t total = offsets[segment_count] - offsets[0];
+    ThreadPool* pool = (threads > 1 && total > 2 * SEGMENT_TASK_GRAIN) ? thread_pool_create(threads) : NULL;
+    segmented_sort_in_pool(pool, data, offsets, segment_count);
+    thread_pool_destroy(pool);
+
+    return true;
+}
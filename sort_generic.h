@@ -0,0 +1,235 @@
+/**
+ * @file sort_generic.h
+ * @brief Macro-generated sorting kernels for arbitrary element types
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * SORT_DEFINE(name, type, less) instantiates a family of kernels for one
+ * element type, with the comparison inlined instead of called through a
+ * function pointer. `less` is a function-like macro or inline function
+ * taking two values and returning non-zero when the first orders strictly
+ * before the second:
+ *
+ *     #define BY_KEY(a, b) ((a).key < (b).key)
+ *     SORT_DEFINE(record, Record, BY_KEY)
+ *
+ * defines record_insertion_sort(), record_quick_sort(), record_merge_sort(),
+ * record_merge_sort_with_buffer(), record_comb_sort() and record_heap_sort(),
+ * all taking (type arr[], size_t size). SORT_DECLARE(name, type) emits the
+ * matching prototypes for kernels instantiated in another translation unit
+ * with SORT_DEFINE_SCOPED(, name, type, less).
+ *
+ * The generated kernels do not update comparison_count/permutation_count
+ * and never report trace steps.
+ */
+
+#ifndef SORT_GENERIC_H
+#define SORT_GENERIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Ranges at or below this size are finished with insertion sort */
+#define SORT_GENERIC_INSERTION_THRESHOLD 16
+
+/* Natural ordering for integer types */
+#define SORT_LESS_NUMERIC(a, b) ((a) < (b))
+
+/* Total ordering for floating-point types: NaNs sort after every number */
+#define SORT_LESS_FLOATING(a, b) ((a) < (b) || ((b) != (b) && (a) == (a)))
+
+/**
+ * @brief Declare the kernels of a family defined in another translation unit
+ */
+#define SORT_DECLARE(name, type) \
+    void name##_insertion_sort(type arr[], size_t size); \
+    void name##_heap_sort(type arr[], size_t size); \
+    void name##_quick_sort(type arr[], size_t size); \
+    void name##_merge_sort_with_buffer(type arr[], size_t size, type scratch[]); \
+    bool name##_merge_sort(type arr[], size_t size); \
+    void name##_comb_sort(type arr[], size_t size);
+
+/**
+ * @brief Define a kernel family with file-local linkage
+ */
+#define SORT_DEFINE(name, type, less) SORT_DEFINE_SCOPED(static inline, name, type, less)
+
+/**
+ * @brief Define a kernel family; `scope` prefixes the public kernels
+ * (leave it empty for external linkage)
+ *
+ * Kernels:
+ * - insertion_sort: O(n²), stable
+ * - heap_sort: O(n log n), in place
+ * - quick_sort: introsort (median-of-three, heap sort fallback), O(n log n)
+ * - merge_sort_with_buffer: bottom-up, stable, uses a size-element scratch
+ * - merge_sort: allocates the scratch; returns false (array untouched) on failure
+ * - comb_sort: shrink factor 1.3, in place
+ */
+#define SORT_DEFINE_SCOPED(scope, name, type, less) \
+    \
+    static inline void name##_insertion_range(type arr[], size_t lo, size_t hi) { \
+        for (size_t i = lo + 1; i < hi; i++) { \
+            type key = arr[i]; \
+            size_t j = i; \
+            while (j > lo && less(key, arr[j - 1])) { \
+                arr[j] = arr[j - 1]; \
+                j--; \
+            } \
+            arr[j] = key; \
+        } \
+    } \
+    \
+    scope void name##_insertion_sort(type arr[], size_t size) { \
+        name##_insertion_range(arr, 0, size); \
+    } \
+    \
+    static inline void name##_sift_down(type arr[], size_t root, size_t size) { \
+        type value = arr[root]; \
+        while (2 * root + 1 < size) { \
+            size_t child = 2 * root + 1; \
+            if (child + 1 < size && less(arr[child], arr[child + 1])) { \
+                child++; \
+            } \
+            if (!less(value, arr[child])) { \
+                break; \
+            } \
+            arr[root] = arr[child]; \
+            root = child; \
+        } \
+        arr[root] = value; \
+    } \
+    \
+    scope void name##_heap_sort(type arr[], size_t size) { \
+        for (size_t i = size / 2; i > 0; i--) { \
+            name##_sift_down(arr, i - 1, size); \
+        } \
+        for (size_t end = size; end > 1; end--) { \
+            type temp = arr[0]; \
+            arr[0] = arr[end - 1]; \
+            arr[end - 1] = temp; \
+            name##_sift_down(arr, 0, end - 1); \
+        } \
+    } \
+    \
+    /* Sort arr[a], arr[b], arr[c] so arr[b] holds their median */ \
+    static inline void name##_order3(type arr[], size_t a, size_t b, size_t c) { \
+        type temp; \
+        if (less(arr[b], arr[a])) { temp = arr[a]; arr[a] = arr[b]; arr[b] = temp; } \
+        if (less(arr[c], arr[b])) { temp = arr[b]; arr[b] = arr[c]; arr[c] = temp; } \
+        if (less(arr[b], arr[a])) { temp = arr[a]; arr[a] = arr[b]; arr[b] = temp; } \
+    } \
+    \
+    /* Hoare partition of arr[lo..hi) around a median-of-three pivot */ \
+    static inline size_t name##_partition(type arr[], size_t lo, size_t hi) { \
+        size_t mid = lo + (hi - lo) / 2; \
+        name##_order3(arr, lo, mid, hi - 1); \
+        type pivot = arr[mid]; \
+        size_t i = lo; \
+        size_t j = hi - 1; \
+        for (;;) { \
+            do { i++; } while (less(arr[i], pivot)); \
+            do { j--; } while (less(pivot, arr[j])); \
+            if (i >= j) { \
+                return j + 1; \
+            } \
+            type temp = arr[i]; \
+            arr[i] = arr[j]; \
+            arr[j] = temp; \
+        } \
+    } \
+    \
+    static inline void name##_introsort_loop(type arr[], size_t lo, size_t hi, int depth) { \
+        while (hi - lo > SORT_GENERIC_INSERTION_THRESHOLD) { \
+            if (depth == 0) { \
+                name##_heap_sort(arr + lo, hi - lo); \
+                return; \
+            } \
+            depth--; \
+            size_t cut = name##_partition(arr, lo, hi); \
+            if (cut - lo < hi - cut) { \
+                name##_introsort_loop(arr, lo, cut, depth); \
+                lo = cut; \
+            } else { \
+                name##_introsort_loop(arr, cut, hi, depth); \
+                hi = cut; \
+            } \
+        } \
+        name##_insertion_range(arr, lo, hi); \
+    } \
+    \
+    scope void name##_quick_sort(type arr[], size_t size) { \
+        int depth = 0; \
+        for (size_t n = size; n > 1; n >>= 1) { \
+            depth += 2; \
+        } \
+        name##_introsort_loop(arr, 0, size, depth); \
+    } \
+    \
+    scope void name##_merge_sort_with_buffer(type arr[], size_t size, type scratch[]) { \
+        for (size_t lo = 0; lo < size; lo += SORT_GENERIC_INSERTION_THRESHOLD) { \
+            size_t hi = lo + SORT_GENERIC_INSERTION_THRESHOLD; \
+            name##_insertion_range(arr, lo, hi < size ? hi : size); \
+        } \
+        type* src = arr; \
+        type* dst = scratch; \
+        for (size_t width = SORT_GENERIC_INSERTION_THRESHOLD; width < size; width *= 2) { \
+            for (size_t lo = 0; lo < size; lo += 2 * width) { \
+                size_t mid = (lo + width < size) ? lo + width : size; \
+                size_t hi = (mid + width < size) ? mid + width : size; \
+                size_t i = lo, j = mid, k = lo; \
+                while (i < mid && j < hi) { \
+                    dst[k++] = less(src[j], src[i]) ? src[j++] : src[i++]; \
+                } \
+                while (i < mid) { \
+                    dst[k++] = src[i++]; \
+                } \
+                while (j < hi) { \
+                    dst[k++] = src[j++]; \
+                } \
+            } \
+            type* temp = src; \
+            src = dst; \
+            dst = temp; \
+        } \
+        if (src != arr) { \
+            memcpy(arr, src, size * sizeof(type)); \
+        } \
+    } \
+    \
+    scope bool name##_merge_sort(type arr[], size_t size) { \
+        if (size < 2) { \
+            return true; \
+        } \
+        type* scratch = malloc(size * sizeof(type)); \
+        if (scratch == NULL) { \
+            return false; \
+        } \
+        name##_merge_sort_with_buffer(arr, size, scratch); \
+        free(scratch); \
+        return true; \
+    } \
+    \
+    scope void name##_comb_sort(type arr[], size_t size) { \
+        size_t gap = size; \
+        bool swapped = true; \
+        while (gap != 1 || swapped) { \
+            gap = (gap * 10) / 13; \
+            if (gap < 1) { \
+                gap = 1; \
+            } \
+            swapped = false; \
+            for (size_t i = 0; i + gap < size; i++) { \
+                if (less(arr[i + gap], arr[i])) { \
+                    type temp = arr[i]; \
+                    arr[i] = arr[i + gap]; \
+                    arr[i + gap] = temp; \
+                    swapped = true; \
+                } \
+            } \
+        } \
+    }
+
+#endif /* SORT_GENERIC_H */
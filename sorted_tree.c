@@ -0,0 +1,699 @@
+/**
+ * @file sorted_tree.c
+ * @brief Sorted container for streaming inserts (order-statistic B+-tree)
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Keys live in leaves of up to SORTED_TREE_LEAF_CAPACITY sorted ints. The
+ * leaves are chained left to right for range iteration. Inner nodes hold
+ * up to SORTED_TREE_INNER_CAPACITY children, their separators, and the
+ * number of keys under each child. These subtree sizes give rank and
+ * select in one descent. Wide nodes keep the tree shallow (four levels
+ * hold tens of millions of keys). Nodes are searched by counting the
+ * smaller keys with vector compares rather than by binary search.
+ *
+ * Duplicate keys are allowed. Separators only bound their neighbours: every
+ * key left of separator s is <= s and every key right of it is >= s. So a
+ * run of equal keys may span leaves, and deletions never touch separators
+ * unless nodes are rebalanced.
+ */
+
+#include "sorting_algorithms.h"
+
+/* Keys per leaf (256 bytes) and children per inner node */
+#define SORTED_TREE_LEAF_CAPACITY 64
+#define SORTED_TREE_INNER_CAPACITY 32
+
+/* Nodes below these counts are refilled from a sibling after a removal */
+#define SORTED_TREE_LEAF_MIN (SORTED_TREE_LEAF_CAPACITY / 4)
+#define SORTED_TREE_INNER_MIN (SORTED_TREE_INNER_CAPACITY / 4)
+
+/* Inner levels supported (far beyond any addressable key count) */
+#define SORTED_TREE_MAX_HEIGHT 24
+
+struct SortedTreeLeaf {
+    int count;
+    int keys[SORTED_TREE_LEAF_CAPACITY];
+    SortedTreeLeaf* next;
+};
+
+typedef struct {
+    int count;                                      /* children */
+    int keys[SORTED_TREE_INNER_CAPACITY];           /* keys[i] separates children i and i+1;
+                                                       the last slot pads the search */
+    void* children[SORTED_TREE_INNER_CAPACITY];
+    size_t sizes[SORTED_TREE_INNER_CAPACITY];       /* keys under each child */
+} InnerNode;
+
+struct SortedTree {
+    void* root;     /* a leaf when height is 0 */
+    int height;     /* number of inner levels */
+    size_t size;
+};
+
+/**
+ * @brief Descent from the root to one leaf position
+ */
+typedef struct {
+    InnerNode* nodes[SORTED_TREE_MAX_HEIGHT];
+    int index[SORTED_TREE_MAX_HEIGHT];
+    SortedTreeLeaf* leaf;
+    int position;
+} TreePath;
+
+/**
+ * @brief Number of keys < key (lower) or <= key (upper) in keys[0..count)
+ *
+ * Counts matches over the whole node instead of binary searching. With
+ * capacity a compile-time constant, the compiler turns the loop into
+ * vector compares, with no chain of dependent loads or mispredicted
+ * branches. Slots past count must be initialized; their values are masked.
+ */
+static inline int search_keys(const int keys[], int capacity, int count, int key, bool upper) {
+    int found = 0;
+    if (upper) {
+        for (int i = 0; i < capacity; i++) {
+            found += (keys[i] <= key) & (i < count);
+        }
+    } else {
+        for (int i = 0; i < capacity; i++) {
+            found += (keys[i] < key) & (i < count);
+        }
+    }
+    return found;
+}
+
+static size_t inner_size(const InnerNode* node) {
+    size_t total = 0;
+    for (int i = 0; i < node->count; i++) {
+        total += node->sizes[i];
+    }
+    return total;
+}
+
+/**
+ * @brief Descend by key to the first position holding a key >= key
+ *        (upper false) or > key (upper true)
+ * @param rank If not NULL, receives the number of keys before that
+ *        position (inserts skip the summing)
+ */
+static void descend_key(const SortedTree* tree, int key, bool upper, TreePath* path, size_t* rank) {
+    void* node = tree->root;
+    size_t before = 0;
+
+    for (int level = 0; level < tree->height; level++) {
+        InnerNode* inner = node;
+        int child = search_keys(inner->keys, SORTED_TREE_INNER_CAPACITY, inner->count - 1, key, upper);
+        for (int i = 0; rank != NULL && i < child; i++) {
+            before += inner->sizes[i];
+        }
+        path->nodes[level] = inner;
+        path->index[level] = child;
+        node = inner->children[child];
+    }
+    path->leaf = node;
+    path->position =
+        search_keys(path->leaf->keys, SORTED_TREE_LEAF_CAPACITY, path->leaf->count, key, upper);
+    if (rank != NULL) {
+        *rank = before + (size_t)path->position;
+    }
+}
+
+/**
+ * @brief Descend by rank to the position of the rank-th smallest key
+ *        (rank < size)
+ */
+static void descend_rank(const SortedTree* tree, size_t rank, TreePath* path) {
+    void* node = tree->root;
+
+    for (int level = 0; level < tree->height; level++) {
+        InnerNode* inner = node;
+        int child = 0;
+        while (rank >= inner->sizes[child]) {
+            rank -= inner->sizes[child++];
+        }
+        path->nodes[level] = inner;
+        path->index[level] = child;
+        node = inner->children[child];
+    }
+    path->leaf = node;
+    path->position = (int)rank;
+}
+
+static void free_subtree(void* node, int height) {
+    if (height > 0) {
+        InnerNode* inner = node;
+        for (int i = 0; i < inner->count; i++) {
+            free_subtree(inner->children[i], height - 1);
+        }
+    }
+    free(node);
+}
+
+/**
+ * @brief Create an empty sorted container
+ * @return The container, or NULL if memory could not be allocated
+ */
+SortedTree* sorted_tree_create(void) {
+    SortedTree* tree = malloc(sizeof(SortedTree));
+    SortedTreeLeaf* leaf = calloc(1, sizeof(SortedTreeLeaf));
+    if (tree == NULL || leaf == NULL) {
+        free(tree);
+        free(leaf);
+        return NULL;
+    }
+    tree->root = leaf;
+    tree->height = 0;
+    tree->size = 0;
+    return tree;
+}
+
+/**
+ * @brief Free a container and every node (NULL is ignored)
+ */
+void sorted_tree_destroy(SortedTree* tree) {
+    if (tree == NULL) {
+        return;
+    }
+    free_subtree(tree->root, tree->height);
+    free(tree);
+}
+
+/**
+ * @brief Number of keys in the container
+ */
+size_t sorted_tree_size(const SortedTree* tree) {
+    return tree->size;
+}
+
+/**
+ * @brief Split a full leaf around a new key; the upper keys go to right
+ *
+ * An append to the last leaf keeps the full leaf as is, so ascending
+ * streams fill every leaf instead of leaving them half empty.
+ * @return First key of right (the new separator)
+ */
+static int split_leaf(SortedTreeLeaf* leaf, SortedTreeLeaf* right, int position, int key) {
+    int merged[SORTED_TREE_LEAF_CAPACITY + 1];
+    memcpy(merged, leaf->keys, (size_t)position * sizeof(int));
+    merged[position] = key;
+    memcpy(merged + position + 1, leaf->keys + position,
+           (size_t)(SORTED_TREE_LEAF_CAPACITY - position) * sizeof(int));
+
+    bool append = leaf->next == NULL && position == SORTED_TREE_LEAF_CAPACITY;
+    int left_count = append ? SORTED_TREE_LEAF_CAPACITY : (SORTED_TREE_LEAF_CAPACITY + 1) / 2;
+    memcpy(leaf->keys, merged, (size_t)left_count * sizeof(int));
+    leaf->count = left_count;
+    right->count = SORTED_TREE_LEAF_CAPACITY + 1 - left_count;
+    memcpy(right->keys, merged + left_count, (size_t)right->count * sizeof(int));
+    right->next = leaf->next;
+    leaf->next = right;
+    return right->keys[0];
+}
+
+/**
+ * @brief Insert child right after child index of a node that has room;
+ *        child index now holds left_size keys
+ */
+static void inner_insert(InnerNode* node, int index, int separator, void* right, size_t left_size,
+                         size_t right_size) {
+    int moved = node->count - index - 1;
+    memmove(node->keys + index + 1, node->keys + index, (size_t)moved * sizeof(int));
+    memmove(node->children + index + 2, node->children + index + 1, (size_t)moved * sizeof(void*));
+    memmove(node->sizes + index + 2, node->sizes + index + 1, (size_t)moved * sizeof(size_t));
+    node->keys[index] = separator;
+    node->children[index + 1] = right;
+    node->sizes[index] = left_size;
+    node->sizes[index + 1] = right_size;
+    node->count++;
+}
+
+/**
+ * @brief Split a full inner node while inserting child right after index
+ * @param separator In: separator of the new child; out: separator
+ *        between node and sibling
+ */
+static void split_inner(InnerNode* node, InnerNode* sibling, int index, int* separator, void* right,
+                        size_t left_size, size_t right_size) {
+    int keys[SORTED_TREE_INNER_CAPACITY];
+    void* children[SORTED_TREE_INNER_CAPACITY + 1];
+    size_t sizes[SORTED_TREE_INNER_CAPACITY + 1];
+    int count = SORTED_TREE_INNER_CAPACITY + 1;
+
+    for (int i = 0, from = 0; i < count; i++) {
+        if (i == index + 1) {
+            children[i] = right;
+            sizes[i] = right_size;
+        } else {
+            children[i] = node->children[from];
+            sizes[i] = i == index ? left_size : node->sizes[from];
+            from++;
+        }
+    }
+    for (int i = 0, from = 0; i < count - 1; i++) {
+        keys[i] = i == index ? *separator : node->keys[from++];
+    }
+
+    int left_count = count / 2;
+    node->count = left_count;
+    memcpy(node->keys, keys, (size_t)(left_count - 1) * sizeof(int));
+    memcpy(node->children, children, (size_t)left_count * sizeof(void*));
+    memcpy(node->sizes, sizes, (size_t)left_count * sizeof(size_t));
+    sibling->count = count - left_count;
+    memcpy(sibling->keys, keys + left_count, (size_t)(sibling->count - 1) * sizeof(int));
+    memcpy(sibling->children, children + left_count, (size_t)sibling->count * sizeof(void*));
+    memcpy(sibling->sizes, sizes + left_count, (size_t)sibling->count * sizeof(size_t));
+    *separator = keys[left_count - 1];
+}
+
+/**
+ * @brief Insert into a full leaf, splitting up the path as needed
+ *
+ * Every node the split cascade needs is allocated first, so a failed
+ * allocation leaves the tree unchanged.
+ */
+static bool insert_with_split(SortedTree* tree, TreePath* path, int key) {
+    int level = tree->height;
+    while (level > 0 && path->nodes[level - 1]->count == SORTED_TREE_INNER_CAPACITY) {
+        level--;
+    }
+    int inner_needed = tree->height - level + (level == 0);
+    if (level == 0 && tree->height == SORTED_TREE_MAX_HEIGHT) {
+        return false;
+    }
+
+    InnerNode* spare[SORTED_TREE_MAX_HEIGHT + 1];
+    SortedTreeLeaf* right_leaf = calloc(1, sizeof(SortedTreeLeaf));
+    int allocated = 0;
+    while (right_leaf != NULL && allocated < inner_needed &&
+           (spare[allocated] = calloc(1, sizeof(InnerNode))) != NULL) {
+        allocated++;
+    }
+    if (right_leaf == NULL || allocated < inner_needed) {
+        free(right_leaf);
+        while (allocated > 0) {
+            free(spare[--allocated]);
+        }
+        return false;
+    }
+
+    int separator = split_leaf(path->leaf, right_leaf, path->position, key);
+    void* left = path->leaf;
+    void* right = right_leaf;
+    size_t left_size = (size_t)path->leaf->count;
+    size_t right_size = (size_t)right_leaf->count;
+
+    for (level = tree->height - 1; level >= 0; level--) {
+        InnerNode* node = path->nodes[level];
+        int index = path->index[level];
+        if (right == NULL) {
+            node->sizes[index]++;
+        } else if (node->count < SORTED_TREE_INNER_CAPACITY) {
+            inner_insert(node, index, separator, right, left_size, right_size);
+            right = NULL;
+        } else {
+            InnerNode* sibling = spare[--allocated];
+            split_inner(node, sibling, index, &separator, right, left_size, right_size);
+            left = node;
+            right = sibling;
+            left_size = inner_size(node);
+            right_size = inner_size(sibling);
+        }
+    }
+
+    if (right != NULL) {
+        InnerNode* root = spare[--allocated];
+        root->count = 2;
+        root->keys[0] = separator;
+        root->children[0] = left;
+        root->children[1] = right;
+        root->sizes[0] = left_size;
+        root->sizes[1] = right_size;
+        tree->root = root;
+        tree->height++;
+    }
+    tree->size++;
+    return true;
+}
+
+/**
+ * @brief Insert a key (duplicates are kept, after equal keys)
+ * Time Complexity: O(log n)
+ * @return false if memory could not be allocated (tree unchanged)
+ */
+bool sorted_tree_insert(SortedTree* tree, int key) {
+    TreePath path;
+    descend_key(tree, key, true, &path, NULL);
+
+    SortedTreeLeaf* leaf = path.leaf;
+    if (leaf->count == SORTED_TREE_LEAF_CAPACITY) {
+        return insert_with_split(tree, &path, key);
+    }
+
+    memmove(leaf->keys + path.position + 1, leaf->keys + path.position,
+            (size_t)(leaf->count - path.position) * sizeof(int));
+    leaf->keys[path.position] = key;
+    leaf->count++;
+    for (int level = 0; level < tree->height; level++) {
+        path.nodes[level]->sizes[path.index[level]]++;
+    }
+    tree->size++;
+    return true;
+}
+
+/**
+ * @brief Remove child index (>= 1) and the separator before it
+ */
+static void inner_remove(InnerNode* node, int index) {
+    int moved = node->count - index - 1;
+    memmove(node->keys + index - 1, node->keys + index, (size_t)moved * sizeof(int));
+    memmove(node->children + index, node->children + index + 1, (size_t)moved * sizeof(void*));
+    memmove(node->sizes + index, node->sizes + index + 1, (size_t)moved * sizeof(size_t));
+    node->count--;
+}
+
+/**
+ * @brief Refill an underfull leaf child from its neighbour: merge the
+ *        two when they fit in one leaf, otherwise even them out
+ */
+static void rebalance_leaf(InnerNode* parent, int index) {
+    int left_index = index > 0 ? index - 1 : index;
+    SortedTreeLeaf* left = parent->children[left_index];
+    SortedTreeLeaf* right = parent->children[left_index + 1];
+
+    if (left->count + right->count <= SORTED_TREE_LEAF_CAPACITY) {
+        memcpy(left->keys + left->count, right->keys, (size_t)right->count * sizeof(int));
+        left->count += right->count;
+        left->next = right->next;
+        free(right);
+        inner_remove(parent, left_index + 1);
+        parent->sizes[left_index] = (size_t)left->count;
+        return;
+    }
+
+    int target = (left->count + right->count) / 2;
+    if (left->count < target) {
+        int moved = target - left->count;
+        memcpy(left->keys + left->count, right->keys, (size_t)moved * sizeof(int));
+        memmove(right->keys, right->keys + moved, (size_t)(right->count - moved) * sizeof(int));
+        left->count += moved;
+        right->count -= moved;
+    } else {
+        int moved = left->count - target;
+        memmove(right->keys + moved, right->keys, (size_t)right->count * sizeof(int));
+        memcpy(right->keys, left->keys + target, (size_t)moved * sizeof(int));
+        left->count -= moved;
+        right->count += moved;
+    }
+    parent->keys[left_index] = right->keys[0];
+    parent->sizes[left_index] = (size_t)left->count;
+    parent->sizes[left_index + 1] = (size_t)right->count;
+}
+
+/**
+ * @brief Refill an underfull inner child from its neighbour: merge the
+ *        two around their separator when they fit, otherwise rotate one
+ *        child through the parent
+ */
+static void rebalance_inner(InnerNode* parent, int index) {
+    int left_index = index > 0 ? index - 1 : index;
+    InnerNode* left = parent->children[left_index];
+    InnerNode* right = parent->children[left_index + 1];
+    int separator = parent->keys[left_index];
+
+    if (left->count + right->count <= SORTED_TREE_INNER_CAPACITY) {
+        left->keys[left->count - 1] = separator;
+        memcpy(left->keys + left->count, right->keys, (size_t)(right->count - 1) * sizeof(int));
+        memcpy(left->children + left->count, right->children, (size_t)right->count * sizeof(void*));
+        memcpy(left->sizes + left->count, right->sizes, (size_t)right->count * sizeof(size_t));
+        left->count += right->count;
+        free(right);
+        inner_remove(parent, left_index + 1);
+        parent->sizes[left_index] = inner_size(left);
+        return;
+    }
+
+    if (left->count < right->count) {
+        left->keys[left->count - 1] = separator;
+        left->children[left->count] = right->children[0];
+        left->sizes[left->count] = right->sizes[0];
+        left->count++;
+        parent->keys[left_index] = right->keys[0];
+        memmove(right->keys, right->keys + 1, (size_t)(right->count - 2) * sizeof(int));
+        memmove(right->children, right->children + 1, (size_t)(right->count - 1) * sizeof(void*));
+        memmove(right->sizes, right->sizes + 1, (size_t)(right->count - 1) * sizeof(size_t));
+        right->count--;
+    } else {
+        memmove(right->keys + 1, right->keys, (size_t)(right->count - 1) * sizeof(int));
+        memmove(right->children + 1, right->children, (size_t)right->count * sizeof(void*));
+        memmove(right->sizes + 1, right->sizes, (size_t)right->count * sizeof(size_t));
+        right->keys[0] = separator;
+        right->children[0] = left->children[left->count - 1];
+        right->sizes[0] = left->sizes[left->count - 1];
+        right->count++;
+        parent->keys[left_index] = left->keys[left->count - 2];
+        left->count--;
+    }
+    parent->sizes[left_index] = inner_size(left);
+    parent->sizes[left_index + 1] = inner_size(right);
+}
+
+/**
+ * @brief Remove the key at a path position and rebalance up the path
+ */
+static void remove_at(SortedTree* tree, const TreePath* path) {
+    SortedTreeLeaf* leaf = path->leaf;
+    memmove(leaf->keys + path->position, leaf->keys + path->position + 1,
+            (size_t)(leaf->count - path->position - 1) * sizeof(int));
+    leaf->count--;
+    for (int level = 0; level < tree->height; level++) {
+        path->nodes[level]->sizes[path->index[level]]--;
+    }
+    tree->size--;
+
+    // A merge can leave the parent underfull in turn
+    for (int level = tree->height - 1; level >= 0; level--) {
+        InnerNode* parent = path->nodes[level];
+        int index = path->index[level];
+        if (level == tree->height - 1) {
+            if (((SortedTreeLeaf*)parent->children[index])->count >= SORTED_TREE_LEAF_MIN) {
+                break;
+            }
+            rebalance_leaf(parent, index);
+        } else {
+            if (((InnerNode*)parent->children[index])->count >= SORTED_TREE_INNER_MIN) {
+                break;
+            }
+            rebalance_inner(parent, index);
+        }
+    }
+
+    while (tree->height > 0 && ((InnerNode*)tree->root)->count == 1) {
+        InnerNode* root = tree->root;
+        tree->root = root->children[0];
+        tree->height--;
+        free(root);
+    }
+}
+
+/**
+ * @brief Find the first occurrence of key
+ * @return false if the key is not in the tree
+ */
+static bool find_key(const SortedTree* tree, int key, TreePath* path) {
+    size_t rank;
+    descend_key(tree, key, false, path, &rank);
+    if (path->position == path->leaf->count) {
+        // The first key >= key opens the next leaf
+        if (rank == tree->size) {
+            return false;
+        }
+        descend_rank(tree, rank, path);
+    }
+    return path->leaf->keys[path->position] == key;
+}
+
+/**
+ * @brief Remove one occurrence of a key
+ * Time Complexity: O(log n)
+ * @return false if the key is not in the tree
+ */
+bool sorted_tree_remove(SortedTree* tree, int key) {
+    TreePath path;
+    if (!find_key(tree, key, &path)) {
+        return false;
+    }
+    remove_at(tree, &path);
+    return true;
+}
+
+/**
+ * @brief Whether the tree holds at least one occurrence of key
+ * Time Complexity: O(log n)
+ */
+bool sorted_tree_contains(const SortedTree* tree, int key) {
+    TreePath path;
+    return find_key(tree, key, &path);
+}
+
+/**
+ * @brief Number of keys strictly less than key
+ * Time Complexity: O(log n)
+ */
+size_t sorted_tree_rank(const SortedTree* tree, int key) {
+    TreePath path;
+    size_t rank;
+    descend_key(tree, key, false, &path, &rank);
+    return rank;
+}
+
+/**
+ * @brief The rank-th smallest key (0-based)
+ * Time Complexity: O(log n)
+ * @return false if rank >= sorted_tree_size()
+ */
+bool sorted_tree_select(const SortedTree* tree, size_t rank, int* key) {
+    if (rank >= tree->size) {
+        return false;
+    }
+    TreePath path;
+    descend_rank(tree, rank, &path);
+    *key = path.leaf->keys[path.position];
+    return true;
+}
+
+/**
+ * @brief Start iterating over the keys in [low, high], in order
+ *
+ * Any insertion or removal invalidates the cursor.
+ * Time Complexity: O(log n), then O(1) per sorted_tree_next()
+ */
+void sorted_tree_range(const SortedTree* tree, int low, int high, SortedTreeCursor* cursor) {
+    TreePath path;
+    descend_key(tree, low, false, &path, NULL);
+    cursor->leaf = path.leaf;
+    cursor->index = path.position;
+    cursor->high = high;
+}
+
+/**
+ * @brief Next key of a range
+ * @return false once the range is exhausted
+ */
+bool sorted_tree_next(SortedTreeCursor* cursor, int* key) {
+    while (cursor->leaf != NULL && cursor->index == cursor->leaf->count) {
+        cursor->leaf = cursor->leaf->next;
+        cursor->index = 0;
+    }
+    if (cursor->leaf == NULL || cursor->leaf->keys[cursor->index] > cursor->high) {
+        cursor->leaf = NULL;
+        return false;
+    }
+    *key = cursor->leaf->keys[cursor->index++];
+    return true;
+}
+
+/**
+ * @brief Replace the contents with an ascending array, bottom-up
+ *
+ * Leaves and inner nodes are filled almost completely, which is faster
+ * and more compact than inserting the keys one by one. Sort the input
+ * first with any of the sorting engines.
+ * Time Complexity: O(n)
+ * @return false if the keys are not in ascending order or memory could
+ *         not be allocated (tree unchanged)
+ */
+bool sorted_tree_bulk_load(SortedTree* tree, const int sorted[], size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        if (sorted[i] < sorted[i - 1]) {
+            return false;
+        }
+    }
+
+    // Nodes per level, leaves first; the counts are spread evenly
+    size_t level_nodes[SORTED_TREE_MAX_HEIGHT + 1];
+    size_t total = 0;
+    int height = 0;
+    level_nodes[0] = count == 0 ? 1 : (count + SORTED_TREE_LEAF_CAPACITY - 1) / SORTED_TREE_LEAF_CAPACITY;
+    while (level_nodes[height] > 1) {
+        if (height == SORTED_TREE_MAX_HEIGHT) {
+            return false;
+        }
+        level_nodes[height + 1] =
+            (level_nodes[height] + SORTED_TREE_INNER_CAPACITY - 1) / SORTED_TREE_INNER_CAPACITY;
+        height++;
+    }
+    for (int level = 0; level <= height; level++) {
+        total += level_nodes[level];
+    }
+
+    void** nodes = malloc(total * sizeof(void*));
+    size_t* sizes = malloc(level_nodes[0] * sizeof(size_t));
+    int* firsts = malloc(level_nodes[0] * sizeof(int));
+    size_t allocated = 0;
+    if (nodes != NULL && sizes != NULL && firsts != NULL) {
+        for (; allocated < total; allocated++) {
+            nodes[allocated] = calloc(1, allocated < level_nodes[0] ? sizeof(SortedTreeLeaf)
+                                                                    : sizeof(InnerNode));
+            if (nodes[allocated] == NULL) {
+                break;
+            }
+        }
+    }
+    if (allocated < total) {
+        while (allocated > 0) {
+            free(nodes[--allocated]);
+        }
+        free(nodes);
+        free(sizes);
+        free(firsts);
+        return false;
+    }
+
+    // Leaves: sizes[] and firsts[] describe the nodes of the level below
+    size_t leaves = level_nodes[0];
+    const int* source = sorted;
+    for (size_t i = 0; i < leaves; i++) {
+        SortedTreeLeaf* leaf = nodes[i];
+        leaf->count = (int)(count / leaves + (i < count % leaves));
+        memcpy(leaf->keys, source, (size_t)leaf->count * sizeof(int));
+        source += leaf->count;
+        leaf->next = i + 1 < leaves ? nodes[i + 1] : NULL;
+        sizes[i] = (size_t)leaf->count;
+        firsts[i] = leaf->count > 0 ? leaf->keys[0] : 0;
+    }
+
+    void** below = nodes;
+    for (int level = 1; level <= height; level++) {
+        size_t children = level_nodes[level - 1];
+        size_t parents = level_nodes[level];
+        void** current = below + children;
+        size_t child = 0;
+        for (size_t i = 0; i < parents; i++) {
+            InnerNode* node = current[i];
+            node->count = (int)(children / parents + (i < children % parents));
+            size_t first = child;
+            for (int c = 0; c < node->count; c++, child++) {
+                node->children[c] = below[child];
+                node->sizes[c] = sizes[child];
+                if (c > 0) {
+                    node->keys[c - 1] = firsts[child];
+                }
+            }
+            // Compact in place: entry i is written after entries >= i were read
+            sizes[i] = inner_size(node);
+            firsts[i] = firsts[first];
+        }
+        below = current;
+    }
+
+    free_subtree(tree->root, tree->height);
+    tree->root = below[0];
+    tree->height = height;
+    tree->size = count;
+
+    free(nodes);
+    free(sizes);
+    free(firsts);
+    return true;
+}
@@ -16,39 +16,315 @@
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "sort_generic.h"
 
 /* Constants */
-#define MAX_ROWS 5
-#define MAX_COLS 5
-#define MAX_WORD_LENGTH 100
+#define MATRIX_DEMO_ROWS 5
+#define MATRIX_DEMO_WIDTH 4
 #define MAX_STRING_LENGTH 256
+#define RADIX_DEFAULT_DIGIT_BITS 11
+#define RADIX_MAX_DIGIT_BITS 16
+#define SIMD_SORT_MAX_BLOCK 64
 
 /* Performance counters */
 extern unsigned long long comparison_count;
 extern unsigned long long permutation_count;
+extern unsigned long long bytes_moved_count;
+
+/*
+ * The operation counters cost a load, add and store in every inner loop,
+ * so the kernels only update them when built with -DSORT_COUNTERS
+ * (`make counters`). Otherwise the globals stay at zero and the count
+ * macros expand to nothing; use the hardware counters of perf_counters.c
+ * to see where the time goes.
+ */
+#ifdef SORT_COUNTERS
+#define SORT_COUNTERS_ENABLED 1
+#define SORT_COUNT_COMPARISONS(n) ((void)(comparison_count += (n)))
+#define SORT_COUNT_PERMUTATIONS(n) ((void)(permutation_count += (n)))
+#else
+#define SORT_COUNTERS_ENABLED 0
+#define SORT_COUNT_COMPARISONS(n) ((void)0)
+#define SORT_COUNT_PERMUTATIONS(n) ((void)0)
+#endif
+#define SORT_COUNT_COMPARISON() SORT_COUNT_COMPARISONS(1)
+#define SORT_COUNT_PERMUTATION() SORT_COUNT_PERMUTATIONS(1)
+
+/*
+ * Bytes read plus bytes written by each pass of the merge sorts over the
+ * whole array, a model of their memory traffic. It is added once per pass,
+ * so it is always on.
+ */
+#define SORT_COUNT_BYTES(n) ((void)(bytes_moved_count += (n)))
 
 /* Data structures */
 
 /**
  * @brief Node structure for linked list implementation
+ *
+ * The text is referenced, not embedded: it lives in the same allocation
+ * as the node (create_node) or in a WordList string arena.
  */
 typedef struct Node {
-    char word[MAX_WORD_LENGTH];
+    const char* word;       /* NUL-terminated text */
+    size_t length;          /* strlen(word) */
     struct Node* next;
 } Node;
 
+/**
+ * @brief Table of strings with runtime row count and width
+ *
+ * Rows are stored contiguously in data, each NUL-terminated, and row r
+ * starts at data + offsets[r]. Sorts permute order (row indices) and
+ * leave the text in place; string_table_row() reads rows in that order.
+ */
+typedef struct {
+    char* data;
+    size_t data_size;
+    size_t data_capacity;
+    size_t* offsets;
+    size_t* order;
+    size_t rows;
+    size_t row_capacity;
+} StringTable;
+
+/**
+ * @brief String to sort plus a caller-defined tag (e.g. its row index)
+ */
+typedef struct {
+    const char* text;
+    size_t tag;
+} StringKey;
+
+/**
+ * @brief String with its first 8 bytes cached as a big-endian integer
+ *        (see string_prefix()); comparisons only call strcmp() on a tie
+ */
+typedef struct {
+    uint64_t prefix;
+    const char* text;
+    size_t tag;
+} PrefixKey;
+
+/**
+ * @brief Settings of the external merge sort (see external_sort_default_options())
+ */
+typedef struct {
+    size_t memory_budget;   /* bytes of RAM for chunks and merge buffers */
+    const char* temp_dir;   /* directory receiving the sorted runs */
+    int fan_in;             /* runs merged per pass (>= 2) */
+    size_t element_size;    /* 4 (int32) or 8 (int64), native endianness */
+} ExternalSortOptions;
+
+/**
+ * @brief Bounded min-heap collecting the k largest values of a stream
+ */
+typedef struct {
+    int* values;    /* caller-provided storage of capacity elements */
+    int capacity;
+    int count;
+} TopK;
+
+/**
+ * @brief Partition schemes used by partition() (and so by quick_sort())
+ */
+typedef enum {
+    PARTITION_LOMUTO,           /* default: one scan, one branch per element */
+    PARTITION_BLOCK             /* BlockQuicksort: branchless block classification */
+} PartitionScheme;
+
+/**
+ * @brief Engines auto_sort() can dispatch to
+ */
+typedef enum {
+    SORT_ENGINE_NONE,           /* input already sorted */
+    SORT_ENGINE_INSERTION,
+    SORT_ENGINE_RUN_MERGE,      /* reverse descending runs, then merge the runs */
+    SORT_ENGINE_COUNTING,
+    SORT_ENGINE_RADIX,
+    SORT_ENGINE_INTROSORT
+} SortEngine;
+
+/**
+ * @brief Presortedness probe of an int array and the resulting decision
+ */
+typedef struct {
+    int size;
+    int descents;               /* adjacent pairs with arr[i] > arr[i + 1] */
+    int runs;                   /* non-descending or strictly descending runs (the
+                                   count stops once a run merge would not pay off) */
+    int descending_runs;
+    double inversion_ratio;     /* fraction of sampled pairs i < j that are inverted */
+    double estimated_inversions;
+    int min_value;
+    int max_value;
+    double duplicate_ratio;     /* fraction of equal neighbours in a sorted sample */
+    SortEngine engine;          /* engine that sorted the array */
+    const char* reason;         /* why it was chosen (static string) */
+} SortProbe;
+
+/**
+ * @brief Bump allocator made of chained blocks (see list_sorting.c)
+ */
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* blocks;
+    size_t block_size;
+} Arena;
+
+/**
+ * @brief Linked list of words with O(1) append and single-call release
+ *
+ * Nodes come from a pool arena and their text is copied into a contiguous
+ * string arena. Sort the list in place through &list.head.
+ */
+typedef struct {
+    Node* head;
+    Node* tail;
+    size_t count;
+    Arena nodes;
+    Arena strings;
+} WordList;
+
+/**
+ * @brief Observer notified of intermediate sorting steps
+ *
+ * The sorting kernels never print anything themselves. When an observer is
+ * registered with set_sort_observer(), each kernel reports its passes through
+ * these callbacks; any callback may be left NULL. Building with
+ * -DSORT_NO_TRACE removes the hooks from the kernels entirely.
+ */
+typedef struct SortObserver {
+    void (*on_message)(const char* message);
+    void (*on_array)(const char* label, const int arr[], int size);
+    void (*on_list)(const char* label, const Node* head);
+    void (*on_matrix)(const char* label, const StringTable* table);
+} SortObserver;
+
+/**
+ * @brief Instruction set used by the sorting network kernels
+ */
+typedef enum {
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE41,
+    SIMD_LEVEL_AVX2
+} SimdLevel;
+
+/**
+ * @brief Work-stealing thread pool (see thread_pool.c)
+ */
+typedef struct ThreadPool ThreadPool;
+
+/**
+ * @brief Sorted container with O(log n) updates (see sorted_tree.c)
+ */
+typedef struct SortedTree SortedTree;
+typedef struct SortedTreeLeaf SortedTreeLeaf;
+
+/**
+ * @brief Position of an in-order iteration over a SortedTree range
+ */
+typedef struct {
+    const SortedTreeLeaf* leaf;     /* NULL once the range is exhausted */
+    int index;
+    int high;                       /* last key of the range (inclusive) */
+} SortedTreeCursor;
+
+/**
+ * @brief Set of tasks that can be waited for together
+ */
+typedef struct TaskGroup {
+    atomic_int pending;
+} TaskGroup;
+
+/**
+ * @brief Hardware events measured by perf_counters.c
+ */
+typedef enum {
+    PERF_EVENT_CYCLES,
+    PERF_EVENT_INSTRUCTIONS,
+    PERF_EVENT_L1D_MISSES,
+    PERF_EVENT_LLC_MISSES,
+    PERF_EVENT_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+} PerfEvent;
+
+/**
+ * @brief Set of hardware counters wrapped around a sort call
+ */
+typedef struct {
+    int fds[PERF_EVENT_COUNT];          /* -1: event unavailable */
+    uint64_t values[PERF_EVENT_COUNT];  /* counts of the last start/stop window */
+    int error;                          /* errno of the first failed open, 0 if none */
+} PerfCounters;
+
+/**
+ * @brief Data cache geometry of the first CPU, in bytes (see multiway_sorting.c)
+ */
+typedef struct {
+    size_t l1d;     /* level 1 data cache */
+    size_t l2;      /* level 2 cache */
+    size_t l3;      /* level 3 cache, 0 if absent or unknown */
+    size_t line;    /* cache line */
+} CacheSizes;
+
+/* Observer that prints every step to stdout (used by the interactive demo) */
+extern const SortObserver printing_observer;
+
+/* Currently registered observer, NULL when tracing is off */
+extern const SortObserver* sort_observer;
+
+#ifndef SORT_NO_TRACE
+/* Whether a kernel should prepare state that only a trace step shows */
+#define SORT_TRACE_ENABLED() (sort_observer != NULL)
+#define SORT_TRACE_MESSAGE(...) \
+    do { if (sort_observer != NULL) sort_trace_message(__VA_ARGS__); } while (0)
+#define SORT_TRACE_ARRAY(arr, size, ...) \
+    do { if (sort_observer != NULL) sort_trace_array((arr), (size), __VA_ARGS__); } while (0)
+#define SORT_TRACE_LIST(head, ...) \
+    do { if (sort_observer != NULL) sort_trace_list((head), __VA_ARGS__); } while (0)
+#define SORT_TRACE_MATRIX(table, ...) \
+    do { if (sort_observer != NULL) sort_trace_matrix((table), __VA_ARGS__); } while (0)
+#else
+#define SORT_TRACE_ENABLED() 0
+#define SORT_TRACE_MESSAGE(...) ((void)0)
+#define SORT_TRACE_ARRAY(arr, size, ...) ((void)0)
+#define SORT_TRACE_LIST(head, ...) ((void)0)
+#define SORT_TRACE_MATRIX(table, ...) ((void)0)
+#endif
+
 /* Function prototypes */
 
 /* Utility functions */
 void reset_counters(void);
 void print_statistics(void);
+void print_sort_probe(const SortProbe* probe);
 void generate_random_array(int arr[], int size, int max_value);
-void generate_random_matrix(char matrix[MAX_ROWS][MAX_COLS]);
+bool generate_random_matrix(StringTable* table, size_t rows, size_t width);
 Node* create_linked_list_from_words(const char* words[], int count);
 
+/* Trace functions */
+void set_sort_observer(const SortObserver* observer);
+void sort_trace_message(const char* format, ...);
+void sort_trace_array(const int arr[], int size, const char* format, ...);
+void sort_trace_list(const Node* head, const char* format, ...);
+void sort_trace_matrix(const StringTable* table, const char* format, ...);
+
+/* Hardware performance counters (Linux perf_event_open) */
+bool perf_counters_open(PerfCounters* counters);
+void perf_counters_start(PerfCounters* counters);
+void perf_counters_stop(PerfCounters* counters);
+void perf_counters_close(PerfCounters* counters);
+bool perf_counter_available(const PerfCounters* counters, PerfEvent event);
+const char* perf_event_name(PerfEvent event);
+void print_perf_counters(const PerfCounters* counters);
+
 /* Display functions */
 void display_array(const int arr[], int size);
-void display_matrix(const char matrix[MAX_ROWS][MAX_COLS], int rows);
+void display_matrix(const StringTable* table);
 void display_linked_list(const Node* head);
 
 /* Array sorting algorithms */
@@ -56,24 +332,135 @@ void selection_sort(int arr[], int size);
 void bubble_sort(int arr[], int size);
 void insertion_sort(int arr[], int size);
 void quick_sort(int arr[], int low, int high);
+void pdq_sort(int arr[], int size);
 void merge_sort(int arr[], int left, int right);
+void merge_sort_with_buffer(int arr[], int size, int scratch[]);
 void comb_sort(int arr[], int size);
+void heap_sort(int arr[], int size);
+void radix_sort(int arr[], int size);
+bool radix_sort_int32(int32_t arr[], size_t size, int digit_bits);
+bool radix_sort_uint32(uint32_t arr[], size_t size, int digit_bits);
+bool radix_sort_int64(int64_t arr[], size_t size, int digit_bits);
+bool radix_sort_uint64(uint64_t arr[], size_t size, int digit_bits);
+bool radix_sort_uint64_high(uint64_t arr[], size_t size, int digit_bits, int low_bit);
+void probe_presortedness(const int arr[], int size, SortProbe* probe);
+SortEngine auto_sort(int arr[], int size, SortProbe* probe);
+const char* sort_engine_name(SortEngine engine);
+
+/* Argsort and key/payload sorting */
+bool argsort(const int keys[], size_t count, size_t indices[], bool stable);
+bool sort_by_key(int keys[], size_t count, void* const payloads[],
+                 const size_t payload_sizes[], size_t payload_count, bool stable);
+
+/* Selection and partial sorting */
+void nth_element(int arr[], int size, int k);
+void partial_sort(int arr[], int size, int k);
+void top_k_init(TopK* top, int storage[], int k);
+void top_k_push(TopK* top, int value);
+int top_k_finish(TopK* top);
+int top_k(const int arr[], int size, int k, int out[]);
+
+/* SIMD sorting networks */
+SimdLevel simd_detect_level(void);
+SimdLevel simd_get_level(void);
+SimdLevel simd_set_level(SimdLevel level);
+const char* simd_level_name(SimdLevel level);
+int simd_leaf_size(void);
+void simd_sort_block(int32_t arr[], size_t count);
+void simd_merge_block(int32_t arr[], size_t count);
+
+/* Type-generic sorting (see sort_generic.h for SORT_DEFINE) */
+void generic_sort(void* base, size_t count, size_t size,
+                  int (*compare)(const void*, const void*));
+SORT_DECLARE(int32, int32_t)
+SORT_DECLARE(int64, int64_t)
+SORT_DECLARE(uint64, uint64_t)
+SORT_DECLARE(float, float)
+SORT_DECLARE(double, double)
+
+/* Thread pool */
+int thread_pool_default_threads(void);
+ThreadPool* thread_pool_create(int threads);
+void thread_pool_destroy(ThreadPool* pool);
+int thread_pool_size(const ThreadPool* pool);
+void task_group_init(TaskGroup* group);
+void thread_pool_submit(ThreadPool* pool, TaskGroup* group, void (*function)(void* arg),
+                        void* arg);
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group);
+
+/* Parallel sorting algorithms */
+bool parallel_merge_sort(int arr[], size_t size, int threads);
+void parallel_merge_sort_in_pool(ThreadPool* pool, int arr[], size_t size, int scratch[]);
+bool parallel_sample_sort(int arr[], size_t size, int threads);
+bool parallel_sample_sort_in_pool(ThreadPool* pool, int arr[], size_t size);
+
+/* Segmented sort (many small arrays in one flat buffer) */
+bool segmented_sort(int data[], const size_t offsets[], size_t segment_count, int threads);
+void segmented_sort_in_pool(ThreadPool* pool, int data[], const size_t offsets[],
+                            size_t segment_count);
+
+/* Cache-aware multiway merge sort */
+bool detect_cache_sizes(CacheSizes* caches);
+bool multiway_merge_sort(int arr[], size_t size);
+
+/* Sorted container (B+-tree with subtree sizes) */
+SortedTree* sorted_tree_create(void);
+void sorted_tree_destroy(SortedTree* tree);
+size_t sorted_tree_size(const SortedTree* tree);
+bool sorted_tree_insert(SortedTree* tree, int key);
+bool sorted_tree_remove(SortedTree* tree, int key);
+bool sorted_tree_contains(const SortedTree* tree, int key);
+size_t sorted_tree_rank(const SortedTree* tree, int key);
+bool sorted_tree_select(const SortedTree* tree, size_t rank, int* key);
+void sorted_tree_range(const SortedTree* tree, int low, int high, SortedTreeCursor* cursor);
+bool sorted_tree_next(SortedTreeCursor* cursor, int* key);
+bool sorted_tree_bulk_load(SortedTree* tree, const int sorted[], size_t count);
+
+/* External sorting (data larger than memory) */
+void external_sort_default_options(ExternalSortOptions* options);
+bool external_sort_stream(FILE* in, FILE* out, const ExternalSortOptions* options);
+bool external_sort_file(const char* input_path, const char* output_path,
+                        const ExternalSortOptions* options);
 
 /* Linked list sorting algorithms */
 void insertion_sort_linked_list(Node** head);
 void bubble_sort_linked_list(Node** head);
+void merge_sort_linked_list(Node** head);
+void merge_sort_linked_list_bounded(Node** head);
 
 /* Matrix sorting algorithms */
-void bubble_sort_matrix(char matrix[MAX_ROWS][MAX_COLS], int rows);
-void merge_sort_matrix(char matrix[MAX_ROWS][MAX_COLS], int left, int right);
+bool bubble_sort_matrix(StringTable* table);
+bool merge_sort_matrix(StringTable* table);
+
+/* String sorting algorithms (string tables and lists) */
+void multikey_quick_sort_strings(StringKey keys[], size_t count);
+bool msd_radix_sort_strings(StringKey keys[], size_t count);
+bool multikey_sort_matrix(StringTable* table);
+bool msd_radix_sort_matrix(StringTable* table);
+bool multikey_sort_linked_list(Node** head);
+bool msd_radix_sort_linked_list(Node** head);
+void set_string_prefix_cache(bool enabled);
+uint64_t string_prefix(const char* text);
+bool prefix_key_bubble_pass(PrefixKey keys[], size_t end);
+void prefix_key_merge_pass(const PrefixKey src[], PrefixKey dst[], size_t count, size_t width);
 
 /* Helper functions */
 int partition(int arr[], int low, int high);
-void merge_arrays(int arr[], int left, int mid, int right);
-void merge_matrices(char matrix[MAX_ROWS][MAX_COLS], int left, int mid, int right);
+void set_partition_scheme(PartitionScheme scheme);
+const char* partition_scheme_name(PartitionScheme scheme);
+bool merge_arrays(int arr[], int left, int mid, int right);
 Node* create_node(const char* word);
 void insert_end(Node** head, const char* word);
 void free_linked_list(Node* head);
+void word_list_init(WordList* list);
+bool word_list_append(WordList* list, const char* word, size_t length);
+bool word_list_build(WordList* list, const char* words[], size_t count);
+void word_list_free(WordList* list);
+void string_table_init(StringTable* table);
+bool string_table_reserve(StringTable* table, size_t rows, size_t bytes);
+bool string_table_append(StringTable* table, const char* text, size_t length);
+const char* string_table_row(const StringTable* table, size_t position);
+void string_table_free(StringTable* table);
 
 /* User interface functions */
 void run_array_sorting_demo(void);
@@ -81,5 +468,6 @@ void run_linked_list_sorting_demo(void);
 void run_matrix_sorting_demo(void);
 int get_user_choice(int min, int max, const char* prompt);
 void print_menu(void);
+int run_cli(int argc, char* argv[]);
 
 #endif /* SORTING_ALGORITHMS_H */
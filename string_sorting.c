@@ -0,0 +1,484 @@
+/**
+ * @file string_sorting.c
+ * @brief String-specialized sorting: multikey quicksort and MSD radix sort
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Both engines sort StringKey arrays one character position at a time.
+ * Once a group of keys is known to share a prefix of d characters, only
+ * position d onwards is ever examined again, so long common prefixes
+ * (URLs, file paths) are scanned once instead of on every comparison.
+ *
+ * The string-table and linked-list front ends load the rows or words into
+ * a key array, sort it and apply the resulting order. comparison_count
+ * counts character (or insertion sort string) comparisons and
+ * permutation_count counts key moves.
+ *
+ * The comparison-based string sorts (bubble and merge for tables and
+ * lists) use PrefixKey arrays instead: the first 8 bytes of each string
+ * are cached as a big-endian integer next to the pointer, and strcmp()
+ * only runs when two prefixes tie.
+ */
+
+#include "sorting_algorithms.h"
+
+/* Groups at or below this size are finished with insertion sort */
+#define STRING_INSERTION_THRESHOLD 16
+
+/* Number of MSD buckets: one per byte value, 0 being the end of the string */
+#define MSD_BUCKETS 256
+
+/* Whether string_prefix() caches prefixes (off: every comparison uses strcmp) */
+static bool prefix_cache_enabled = true;
+
+/**
+ * @brief Character of a key at depth d (0 past the end of the string)
+ */
+static int char_at(const StringKey* key, size_t depth) {
+    return (unsigned char)key->text[depth];
+}
+
+static void swap_keys(StringKey keys[], size_t a, size_t b) {
+    StringKey temp = keys[a];
+    keys[a] = keys[b];
+    keys[b] = temp;
+    SORT_COUNT_PERMUTATION();
+}
+
+/**
+ * @brief Insertion sort of keys sharing their first `depth` characters
+ */
+static void insertion_sort_keys(StringKey keys[], size_t count, size_t depth) {
+    for (size_t i = 1; i < count; i++) {
+        StringKey key = keys[i];
+        size_t j = i;
+        while (j > 0) {
+            SORT_COUNT_COMPARISON();
+            if (strcmp(keys[j - 1].text + depth, key.text + depth) <= 0) {
+                break;
+            }
+            keys[j] = keys[j - 1];
+            SORT_COUNT_PERMUTATION();
+            j--;
+        }
+        keys[j] = key;
+    }
+}
+
+/**
+ * @brief Index of the median of three keys by their character at depth
+ */
+static size_t median_of_three_keys(const StringKey keys[], size_t a, size_t b, size_t c,
+                                   size_t depth) {
+    int ca = char_at(&keys[a], depth);
+    int cb = char_at(&keys[b], depth);
+    int cc = char_at(&keys[c], depth);
+
+    if (ca < cb) {
+        return cb < cc ? b : (ca < cc ? c : a);
+    }
+    return ca < cc ? a : (cb < cc ? c : b);
+}
+
+/**
+ * @brief Bentley–Sedgewick multikey quicksort of keys sharing `depth` characters
+ *
+ * Three-way partitions on the character at depth; the < and > groups are
+ * sorted recursively at the same depth and the = group continues (in the
+ * loop, without recursion) at depth + 1 unless the strings ended.
+ */
+static void multikey_loop(StringKey keys[], size_t count, size_t depth) {
+    while (count > STRING_INSERTION_THRESHOLD) {
+        swap_keys(keys, 0, median_of_three_keys(keys, 0, count / 2, count - 1, depth));
+        int pivot = char_at(&keys[0], depth);
+
+        // Invariant: [0, a) and (d, count) == pivot, [a, b) < pivot, (c, d] > pivot
+        size_t a = 1, b = 1, c = count - 1, d = count - 1;
+        for (;;) {
+            while (b <= c) {
+                int ch = char_at(&keys[b], depth);
+                SORT_COUNT_COMPARISON();
+                if (ch > pivot) {
+                    break;
+                }
+                if (ch == pivot) {
+                    swap_keys(keys, a++, b);
+                }
+                b++;
+            }
+            while (b <= c) {
+                int ch = char_at(&keys[c], depth);
+                SORT_COUNT_COMPARISON();
+                if (ch < pivot) {
+                    break;
+                }
+                if (ch == pivot) {
+                    swap_keys(keys, c, d--);
+                }
+                c--;
+            }
+            if (b > c) {
+                break;
+            }
+            swap_keys(keys, b++, c--);
+        }
+
+        // Move the == blocks from both ends into the middle
+        size_t less = b - a;
+        size_t greater = d - c;
+        size_t run = a < less ? a : less;
+        for (size_t i = 0; i < run; i++) {
+            swap_keys(keys, i, b - run + i);
+        }
+        run = greater < count - 1 - d ? greater : count - 1 - d;
+        for (size_t i = 0; i < run; i++) {
+            swap_keys(keys, b + i, count - run + i);
+        }
+
+        multikey_loop(keys, less, depth);
+        multikey_loop(keys + count - greater, greater, depth);
+
+        if (pivot == 0) {
+            return;     // The == group holds identical, fully scanned strings
+        }
+        keys += less;
+        count -= less + greater;
+        depth++;
+    }
+
+    insertion_sort_keys(keys, count, depth);
+}
+
+/**
+ * @brief Multikey quicksort of string keys
+ *
+ * Not stable. Orders like strcmp().
+ * Time Complexity: O(n log n + D) expected, D = total distinguishing prefix length
+ * Space Complexity: O(log n) expected stack
+ * @param keys Keys to sort
+ * @param count Number of keys
+ */
+void multikey_quick_sort_strings(StringKey keys[], size_t count) {
+    multikey_loop(keys, count, 0);
+}
+
+/**
+ * @brief MSD radix sort of keys sharing `depth` characters
+ *
+ * Buckets by the character at depth through `aux`. A depth at which every
+ * key falls into the same non-terminal bucket is skipped without moving
+ * anything. The largest bucket continues in the loop and only the others
+ * recurse, so each frame holds at most half the keys of its caller and the
+ * stack stays O(log n) however deeply the strings nest.
+ */
+static void msd_loop(StringKey keys[], StringKey aux[], size_t count, size_t depth) {
+    while (count > STRING_INSERTION_THRESHOLD) {
+        size_t counts[MSD_BUCKETS] = { 0 };
+        for (size_t i = 0; i < count; i++) {
+            counts[char_at(&keys[i], depth)]++;
+        }
+
+        // Common character at this depth: nothing to distribute
+        int first = char_at(&keys[0], depth);
+        if (counts[first] == count) {
+            if (first == 0) {
+                return;
+            }
+            depth++;
+            continue;
+        }
+
+        size_t starts[MSD_BUCKETS];
+        size_t position = 0;
+        for (int c = 0; c < MSD_BUCKETS; c++) {
+            starts[c] = position;
+            position += counts[c];
+        }
+        for (size_t i = 0; i < count; i++) {
+            aux[starts[char_at(&keys[i], depth)]++] = keys[i];
+        }
+        memcpy(keys, aux, count * sizeof(StringKey));
+        SORT_COUNT_PERMUTATIONS(count);
+
+        // Bucket 0 holds strings that ended: they are already in place
+        int largest = 0;
+        for (int c = 1; c < MSD_BUCKETS; c++) {
+            if (counts[c] > counts[largest]) {
+                largest = c;
+            }
+        }
+
+        size_t largest_start = 0;
+        position = counts[0];
+        for (int c = 1; c < MSD_BUCKETS; c++) {
+            if (c == largest) {
+                largest_start = position;
+            } else if (counts[c] > 1) {
+                msd_loop(keys + position, aux, counts[c], depth + 1);
+            }
+            position += counts[c];
+        }
+        if (largest == 0) {
+            return;
+        }
+        keys += largest_start;
+        count = counts[largest];
+        depth++;
+    }
+
+    insertion_sort_keys(keys, count, depth);
+}
+
+/**
+ * @brief MSD radix sort of string keys
+ *
+ * Not stable. Orders like strcmp(). Groups of at most 16 keys are
+ * finished with insertion sort from their common depth.
+ * Time Complexity: O(D + n·σ) worst case, D = total distinguishing prefix length
+ * Space Complexity: O(n) for the distribution buffer, O(log n) stack
+ * @param keys Keys to sort
+ * @param count Number of keys
+ * @return false if the distribution buffer could not be allocated (keys unchanged)
+ */
+bool msd_radix_sort_strings(StringKey keys[], size_t count) {
+    if (count <= STRING_INSERTION_THRESHOLD) {
+        insertion_sort_keys(keys, count, 0);
+        return true;
+    }
+
+    StringKey* aux = malloc(count * sizeof(StringKey));
+    if (aux == NULL) {
+        return false;
+    }
+    msd_loop(keys, aux, count, 0);
+    free(aux);
+    return true;
+}
+
+/**
+ * @brief Load the rows of a table as keys tagged with their row index
+ */
+static StringKey* table_keys(const StringTable* table) {
+    StringKey* keys = malloc((table->rows > 0 ? table->rows : 1) * sizeof(StringKey));
+    if (keys != NULL) {
+        for (size_t i = 0; i < table->rows; i++) {
+            keys[i].text = string_table_row(table, i);
+            keys[i].tag = table->order[i];
+        }
+    }
+    return keys;
+}
+
+static void apply_table_keys(StringTable* table, const StringKey keys[]) {
+    for (size_t i = 0; i < table->rows; i++) {
+        table->order[i] = keys[i].tag;
+    }
+    SORT_TRACE_MATRIX(table, "After sorting:\n");
+}
+
+/**
+ * @brief Multikey Quicksort for Matrix
+ * Time Complexity: O(n log n + D) expected
+ * Space Complexity: O(n)
+ * @param table Table to sort
+ * @return false if the key array could not be allocated (table unchanged)
+ */
+bool multikey_sort_matrix(StringTable* table) {
+    StringKey* keys = table_keys(table);
+    if (keys == NULL) {
+        return false;
+    }
+    multikey_quick_sort_strings(keys, table->rows);
+    apply_table_keys(table, keys);
+    free(keys);
+    return true;
+}
+
+/**
+ * @brief MSD Radix Sort for Matrix
+ * Time Complexity: O(D + n·σ)
+ * Space Complexity: O(n)
+ * @param table Table to sort
+ * @return false if memory could not be allocated (table unchanged)
+ */
+bool msd_radix_sort_matrix(StringTable* table) {
+    StringKey* keys = table_keys(table);
+    if (keys == NULL) {
+        return false;
+    }
+    bool sorted = msd_radix_sort_strings(keys, table->rows);
+    if (sorted) {
+        apply_table_keys(table, keys);
+    }
+    free(keys);
+    return sorted;
+}
+
+/**
+ * @brief Sort the words of a list with a key engine and relink the nodes
+ * @return false if memory could not be allocated (list unchanged)
+ */
+static bool sort_list_by_keys(Node** head, bool (*engine)(StringKey keys[], size_t count)) {
+    size_t count = 0;
+    for (const Node* current = *head; current != NULL; current = current->next) {
+        count++;
+    }
+    if (count < 2) {
+        return true;
+    }
+
+    Node** nodes = malloc(count * sizeof(Node*));
+    StringKey* keys = malloc(count * sizeof(StringKey));
+    if (nodes == NULL || keys == NULL) {
+        free(nodes);
+        free(keys);
+        return false;
+    }
+
+    size_t i = 0;
+    for (Node* current = *head; current != NULL; current = current->next, i++) {
+        nodes[i] = current;
+        keys[i].text = current->word;
+        keys[i].tag = i;
+    }
+
+    bool sorted = engine(keys, count);
+    if (sorted) {
+        Node** tail = head;
+        for (i = 0; i < count; i++) {
+            *tail = nodes[keys[i].tag];
+            tail = &(*tail)->next;
+        }
+        *tail = NULL;
+        SORT_TRACE_LIST(*head, "After sorting: ");
+    }
+
+    free(nodes);
+    free(keys);
+    return sorted;
+}
+
+static bool multikey_engine(StringKey keys[], size_t count) {
+    multikey_quick_sort_strings(keys, count);
+    return true;
+}
+
+/**
+ * @brief Multikey Quicksort for Linked List
+ *
+ * Relinks the nodes; words are not copied.
+ * Time Complexity: O(n log n + D) expected
+ * Space Complexity: O(n)
+ * @param head Pointer to the head of the list
+ * @return false if memory could not be allocated (list unchanged)
+ */
+bool multikey_sort_linked_list(Node** head) {
+    return sort_list_by_keys(head, multikey_engine);
+}
+
+/**
+ * @brief MSD Radix Sort for Linked List
+ *
+ * Relinks the nodes; words are not copied.
+ * Time Complexity: O(D + n·σ)
+ * Space Complexity: O(n)
+ * @param head Pointer to the head of the list
+ * @return false if memory could not be allocated (list unchanged)
+ */
+bool msd_radix_sort_linked_list(Node** head) {
+    return sort_list_by_keys(head, msd_radix_sort_strings);
+}
+
+/**
+ * @brief Enable or disable prefix caching in the comparison-based string
+ *        sorts (to measure its effect)
+ * @param enabled false makes string_prefix() return 0, so every
+ *        comparison falls through to strcmp()
+ */
+void set_string_prefix_cache(bool enabled) {
+    prefix_cache_enabled = enabled;
+}
+
+/**
+ * @brief First 8 bytes of a string as a big-endian integer
+ *
+ * Bytes past the terminating NUL are zero, so comparing two prefixes as
+ * unsigned integers orders them like strcmp() on their first 8 bytes.
+ * @param text NUL-terminated string
+ * @return Prefix, or 0 when prefix caching is disabled
+ */
+uint64_t string_prefix(const char* text) {
+    uint64_t prefix = 0;
+
+    if (!prefix_cache_enabled) {
+        return 0;
+    }
+    for (int i = 0; i < 8 && text[i] != '\0'; i++) {
+        prefix |= (uint64_t)(unsigned char)text[i] << (56 - 8 * i);
+    }
+    return prefix;
+}
+
+/**
+ * @brief Compare two keys: integer prefix first, strcmp() only on a tie
+ */
+static int compare_prefix_keys(const PrefixKey* a, const PrefixKey* b) {
+    SORT_COUNT_COMPARISON();
+    if (a->prefix != b->prefix) {
+        return a->prefix < b->prefix ? -1 : 1;
+    }
+    return strcmp(a->text, b->text);
+}
+
+/**
+ * @brief One bubble sort pass over keys[0..end)
+ * @param keys Keys to sort
+ * @param end Number of keys still unsorted
+ * @return true if any pair was swapped
+ */
+bool prefix_key_bubble_pass(PrefixKey keys[], size_t end) {
+    bool swapped = false;
+
+    for (size_t j = 0; j + 1 < end; j++) {
+        if (compare_prefix_keys(&keys[j], &keys[j + 1]) > 0) {
+            PrefixKey temp = keys[j];
+            keys[j] = keys[j + 1];
+            keys[j + 1] = temp;
+            swapped = true;
+            SORT_COUNT_PERMUTATION();
+        }
+    }
+
+    return swapped;
+}
+
+/**
+ * @brief One bottom-up merge pass: stable merge of adjacent runs of
+ *        `width` keys from src into dst
+ * @param src Keys whose runs of `width` are sorted
+ * @param dst Output of count keys with sorted runs of 2 * width
+ * @param count Number of keys
+ * @param width Current run width
+ */
+void prefix_key_merge_pass(const PrefixKey src[], PrefixKey dst[], size_t count, size_t width) {
+    for (size_t lo = 0; lo < count; lo += 2 * width) {
+        size_t mid = (lo + width < count) ? lo + width : count;
+        size_t hi = (mid + width < count) ? mid + width : count;
+        size_t i = lo, j = mid, k = lo;
+
+        while (i < mid && j < hi) {
+            if (compare_prefix_keys(&src[i], &src[j]) <= 0) {
+                dst[k++] = src[i++];
+            } else {
+                dst[k++] = src[j++];
+            }
+        }
+        while (i < mid) {
+            dst[k++] = src[i++];
+        }
+        while (j < hi) {
+            dst[k++] = src[j++];
+        }
+        SORT_COUNT_PERMUTATIONS(hi - lo);
+    }
+}
@@ -0,0 +1,373 @@
+/**
+ * @file thread_pool.c
+ * @brief Work-stealing thread pool for fork-join parallel sorts
+ * @author Professional C Developer
+ * @date 2024
+ *
+ * Every participant (the worker threads plus the thread that called into
+ * the pool) owns a deque of tasks. Tasks submitted from a participant go
+ * to the bottom of its own deque; the owner pops from the bottom (LIFO,
+ * cache-warm) and idle participants steal from the top of other deques
+ * (FIFO, large subproblems first). A thread waiting on a TaskGroup keeps
+ * executing tasks until the group completes, so nested fork-join never
+ * blocks a worker.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "sorting_algorithms.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/* Initial capacity of a task deque (grows on demand) */
+#define DEQUE_INITIAL_CAPACITY 64
+
+typedef struct {
+    void (*function)(void* arg);
+    void* arg;
+    TaskGroup* group;
+} Task;
+
+/**
+ * @brief Double-ended task queue protected by a mutex
+ */
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;
+    size_t capacity;
+    size_t head;    /* index of the oldest task (steal end) */
+    size_t count;
+} TaskDeque;
+
+struct ThreadPool {
+    int participants;           /* workers + the calling thread */
+    pthread_t* workers;
+    TaskDeque* deques;          /* one per participant; index 0 is the caller */
+    atomic_int queued;          /* tasks currently sitting in any deque */
+    bool shutdown;
+    pthread_mutex_t sleep_lock;
+    pthread_cond_t wake;
+};
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} WorkerStart;
+
+/* Pool the current thread is a worker of (NULL for other threads) and its deque there */
+static _Thread_local ThreadPool* current_pool = NULL;
+static _Thread_local int current_index = 0;
+
+static bool deque_init(TaskDeque* deque) {
+    deque->tasks = malloc(DEQUE_INITIAL_CAPACITY * sizeof(Task));
+    if (deque->tasks == NULL) {
+        return false;
+    }
+    deque->capacity = DEQUE_INITIAL_CAPACITY;
+    deque->head = 0;
+    deque->count = 0;
+    pthread_mutex_init(&deque->lock, NULL);
+    return true;
+}
+
+static void deque_destroy(TaskDeque* deque) {
+    pthread_mutex_destroy(&deque->lock);
+    free(deque->tasks);
+}
+
+/**
+ * @brief Push a task at the owner's end
+ * @return false if the deque could not grow
+ */
+static bool deque_push(TaskDeque* deque, Task task) {
+    pthread_mutex_lock(&deque->lock);
+
+    if (deque->count == deque->capacity) {
+        Task* grown = malloc(2 * deque->capacity * sizeof(Task));
+        if (grown == NULL) {
+            pthread_mutex_unlock(&deque->lock);
+            return false;
+        }
+        for (size_t i = 0; i < deque->count; i++) {
+            grown[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = grown;
+        deque->capacity *= 2;
+        deque->head = 0;
+    }
+
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+
+    pthread_mutex_unlock(&deque->lock);
+    return true;
+}
+
+/**
+ * @brief Take a task from the owner's end (newest first)
+ */
+static bool deque_pop(TaskDeque* deque, Task* task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->count > 0;
+    if (found) {
+        deque->count--;
+        *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/**
+ * @brief Take a task from the thief's end (oldest first)
+ */
+static bool deque_steal(TaskDeque* deque, Task* task) {
+    pthread_mutex_lock(&deque->lock);
+    bool found = deque->count > 0;
+    if (found) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    pthread_mutex_unlock(&deque->lock);
+    return found;
+}
+
+/**
+ * @brief Find a task: own deque first, then steal from the others
+ */
+static bool find_task(ThreadPool* pool, int self, Task* task) {
+    if (atomic_load(&pool->queued) == 0) {
+        return false;
+    }
+    if (deque_pop(&pool->deques[self], task)) {
+        atomic_fetch_sub(&pool->queued, 1);
+        return true;
+    }
+    for (int k = 1; k < pool->participants; k++) {
+        int victim = (self + k) % pool->participants;
+        if (deque_steal(&pool->deques[victim], task)) {
+            atomic_fetch_sub(&pool->queued, 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Deque of the current thread in a pool
+ *
+ * A worker of one pool may call into another one (a task that runs a
+ * parallel sort); every thread that is not a worker of `pool` uses the
+ * caller deque 0, which is safe because the deques are locked.
+ */
+static int participant_index(const ThreadPool* pool) {
+    return current_pool == pool ? current_index : 0;
+}
+
+static void run_task(const Task* task) {
+    task->function(task->arg);
+    atomic_fetch_sub(&task->group->pending, 1);
+}
+
+static void* worker_main(void* arg) {
+    WorkerStart* start = arg;
+    ThreadPool* pool = start->pool;
+    current_pool = pool;
+    current_index = start->index;
+    free(start);
+
+    for (;;) {
+        Task task;
+        if (find_task(pool, participant_index(pool), &task)) {
+            run_task(&task);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->sleep_lock);
+        while (!pool->shutdown && atomic_load(&pool->queued) == 0) {
+            pthread_cond_wait(&pool->wake, &pool->sleep_lock);
+        }
+        bool stop = pool->shutdown;
+        pthread_mutex_unlock(&pool->sleep_lock);
+
+        if (stop) {
+            return NULL;
+        }
+    }
+}
+
+/**
+ * @brief Stop the running workers and free a (possibly partly built) pool
+ * @param pool Pool to release
+ * @param started Number of participants whose thread is running
+ *        (index 0, the caller, counts as running)
+ * @param ready Number of initialized deques
+ */
+static void release_pool(ThreadPool* pool, int started, int ready) {
+    pthread_mutex_lock(&pool->sleep_lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+
+    for (int i = 1; i < started; i++) {
+        pthread_join(pool->workers[i], NULL);
+    }
+    for (int i = 0; i < ready; i++) {
+        deque_destroy(&pool->deques[i]);
+    }
+
+    pthread_mutex_destroy(&pool->sleep_lock);
+    pthread_cond_destroy(&pool->wake);
+    free(pool->workers);
+    free(pool->deques);
+    free(pool);
+}
+
+/**
+ * @brief Number of online processors (at least 1)
+ */
+int thread_pool_default_threads(void) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    return online > 0 ? (int)online : 1;
+}
+
+/**
+ * @brief Create a pool in which `threads` threads execute tasks
+ *
+ * threads - 1 workers are started; the thread that waits on a TaskGroup
+ * is the remaining participant.
+ * @param threads Total number of participating threads (>= 1)
+ * @return New pool, or NULL if allocation or thread creation failed
+ */
+ThreadPool* thread_pool_create(int threads) {
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->participants = threads;
+    pool->workers = calloc((size_t)threads, sizeof(pthread_t));
+    pool->deques = calloc((size_t)threads, sizeof(TaskDeque));
+    if (pool->workers == NULL || pool->deques == NULL) {
+        free(pool->workers);
+        free(pool->deques);
+        free(pool);
+        return NULL;
+    }
+
+    int ready = 0;
+    while (ready < threads && deque_init(&pool->deques[ready])) {
+        ready++;
+    }
+    atomic_init(&pool->queued, 0);
+    pthread_mutex_init(&pool->sleep_lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+
+    int started = 1;
+    if (ready == threads) {
+        while (started < threads) {
+            WorkerStart* start = malloc(sizeof(WorkerStart));
+            if (start == NULL) {
+                break;
+            }
+            start->pool = pool;
+            start->index = started;
+            if (pthread_create(&pool->workers[started], NULL, worker_main, start) != 0) {
+                free(start);
+                break;
+            }
+            started++;
+        }
+    }
+
+    if (ready < threads || started < threads) {
+        release_pool(pool, started, ready);
+        return NULL;
+    }
+
+    return pool;
+}
+
+/**
+ * @brief Stop the workers and release the pool
+ *
+ * All task groups must have completed.
+ * @param pool Pool to destroy (may be NULL)
+ */
+void thread_pool_destroy(ThreadPool* pool) {
+    if (pool != NULL) {
+        release_pool(pool, pool->participants, pool->participants);
+    }
+}
+
+/**
+ * @brief Number of threads participating in the pool
+ */
+int thread_pool_size(const ThreadPool* pool) {
+    return pool->participants;
+}
+
+/**
+ * @brief Prepare an empty task group
+ */
+void task_group_init(TaskGroup* group) {
+    atomic_init(&group->pending, 0);
+}
+
+/**
+ * @brief Submit a task belonging to a group
+ *
+ * The task is queued on the calling thread's deque, where idle threads
+ * can steal it. If the deque cannot grow the task runs immediately on
+ * the calling thread.
+ * @param pool Pool executing the task
+ * @param group Group that is notified when the task completes
+ * @param function Task body
+ * @param arg Argument passed to the task body
+ */
+void thread_pool_submit(ThreadPool* pool, TaskGroup* group, void (*function)(void* arg),
+                        void* arg) {
+    Task task = { function, arg, group };
+    atomic_fetch_add(&group->pending, 1);
+
+    if (pool->participants == 1) {
+        run_task(&task);
+        return;
+    }
+
+    // Count the task before it becomes visible so thieves never see it uncounted
+    atomic_fetch_add(&pool->queued, 1);
+    if (!deque_push(&pool->deques[participant_index(pool)], task)) {
+        atomic_fetch_sub(&pool->queued, 1);
+        run_task(&task);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->sleep_lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->sleep_lock);
+}
+
+/**
+ * @brief Wait until every task of a group has completed
+ *
+ * The waiting thread executes queued tasks (its own first, then stolen
+ * ones) instead of blocking.
+ * @param pool Pool executing the tasks
+ * @param group Group to wait for
+ */
+void thread_pool_wait(ThreadPool* pool, TaskGroup* group) {
+    while (atomic_load(&group->pending) > 0) {
+        Task task;
+        if (find_task(pool, participant_index(pool), &task)) {
+            run_task(&task);
+        } else {
+            sched_yield();
+        }
+    }
+}
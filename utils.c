@@ -6,10 +6,128 @@
  */
 
 #include "sorting_algorithms.h"
+#include <stdarg.h>
 
 /* Global performance counters */
 unsigned long long comparison_count = 0;
 unsigned long long permutation_count = 0;
+unsigned long long bytes_moved_count = 0;
+
+/* Registered step observer (NULL: kernels run silently) */
+const SortObserver* sort_observer = NULL;
+
+/* Size of the buffer used to format trace labels */
+#define TRACE_LABEL_LENGTH 128
+
+static void print_message(const char* message) {
+    printf("%s\n", message);
+}
+
+static void print_array_step(const char* label, const int arr[], int size) {
+    printf("%s", label);
+    display_array(arr, size);
+}
+
+static void print_list_step(const char* label, const Node* head) {
+    printf("%s", label);
+    display_linked_list(head);
+}
+
+static void print_matrix_step(const char* label, const StringTable* table) {
+    printf("%s", label);
+    display_matrix(table);
+}
+
+const SortObserver printing_observer = {
+    print_message,
+    print_array_step,
+    print_list_step,
+    print_matrix_step
+};
+
+/**
+ * @brief Register the observer notified of sorting steps
+ * @param observer Observer to use, or NULL to disable tracing
+ */
+void set_sort_observer(const SortObserver* observer) {
+    sort_observer = observer;
+}
+
+/**
+ * @brief Report a free-form message to the registered observer
+ * @param format printf-style format of the message
+ */
+void sort_trace_message(const char* format, ...) {
+    if (sort_observer == NULL || sort_observer->on_message == NULL) {
+        return;
+    }
+    
+    char message[TRACE_LABEL_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(message, sizeof(message), format, args);
+    va_end(args);
+    
+    sort_observer->on_message(message);
+}
+
+/**
+ * @brief Report the state of an array to the registered observer
+ * @param arr Array being sorted
+ * @param size Number of elements to report
+ * @param format printf-style format of the step label
+ */
+void sort_trace_array(const int arr[], int size, const char* format, ...) {
+    if (sort_observer == NULL || sort_observer->on_array == NULL) {
+        return;
+    }
+    
+    char label[TRACE_LABEL_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(label, sizeof(label), format, args);
+    va_end(args);
+    
+    sort_observer->on_array(label, arr, size);
+}
+
+/**
+ * @brief Report the state of a linked list to the registered observer
+ * @param head Head of the list being sorted
+ * @param format printf-style format of the step label
+ */
+void sort_trace_list(const Node* head, const char* format, ...) {
+    if (sort_observer == NULL || sort_observer->on_list == NULL) {
+        return;
+    }
+    
+    char label[TRACE_LABEL_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(label, sizeof(label), format, args);
+    va_end(args);
+    
+    sort_observer->on_list(label, head);
+}
+
+/**
+ * @brief Report the state of a string table to the registered observer
+ * @param table Table being sorted
+ * @param format printf-style format of the step label
+ */
+void sort_trace_matrix(const StringTable* table, const char* format, ...) {
+    if (sort_observer == NULL || sort_observer->on_matrix == NULL) {
+        return;
+    }
+    
+    char label[TRACE_LABEL_LENGTH];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(label, sizeof(label), format, args);
+    va_end(args);
+    
+    sort_observer->on_matrix(label, table);
+}
 
 /**
  * @brief Reset performance counters
@@ -17,6 +135,7 @@ unsigned long long permutation_count = 0;
 void reset_counters(void) {
     comparison_count = 0;
     permutation_count = 0;
+    bytes_moved_count = 0;
 }
 
 /**
@@ -24,11 +143,35 @@ void reset_counters(void) {
  */
 void print_statistics(void) {
     printf("\n=== Performance Statistics ===\n");
-    printf("Total comparisons: %llu\n", comparison_count);
-    printf("Total permutations: %llu\n", permutation_count);
+    if (SORT_COUNTERS_ENABLED) {
+        printf("Total comparisons: %llu\n", comparison_count);
+        printf("Total permutations: %llu\n", permutation_count);
+    } else {
+        printf("Operation counters disabled (build with `make counters`)\n");
+    }
+    if (bytes_moved_count > 0) {
+        printf("Bytes moved by merge passes: %llu\n", bytes_moved_count);
+    }
     printf("=============================\n");
 }
 
+/**
+ * @brief Print the probe and the decision of auto_sort()
+ * @param probe Probe filled by auto_sort()
+ */
+void print_sort_probe(const SortProbe* probe) {
+    printf("\n=== Adaptive Sort Decision ===\n");
+    printf("Elements: %d\n", probe->size);
+    printf("Runs: %d (%d descending), descents: %d\n",
+           probe->runs, probe->descending_runs, probe->descents);
+    printf("Estimated inversions: %.0f (%.1f%% of sampled pairs)\n",
+           probe->estimated_inversions, probe->inversion_ratio * 100.0);
+    printf("Key range: [%d, %d], duplicates: %.1f%% of sample\n",
+           probe->min_value, probe->max_value, probe->duplicate_ratio * 100.0);
+    printf("Engine: %s (%s)\n", sort_engine_name(probe->engine), probe->reason);
+    printf("==============================\n");
+}
+
 /**
  * @brief Display array elements
  * @param arr Array to display
@@ -42,13 +185,12 @@ void display_array(const int arr[], int size) {
 }
 
 /**
- * @brief Display matrix rows
- * @param matrix Matrix to display
- * @param rows Number of rows to display
+ * @brief Display the rows of a string table in their current order
+ * @param table Table to display
  */
-void display_matrix(const char matrix[MAX_ROWS][MAX_COLS], int rows) {
-    for (int i = 0; i < rows; i++) {
-        printf("%s\n", matrix[i]);
+void display_matrix(const StringTable* table) {
+    for (size_t i = 0; i < table->rows; i++) {
+        printf("%s\n", string_table_row(table, i));
     }
     printf("\n");
 }
@@ -78,7 +220,13 @@ int get_user_choice(int min, int max, const char* prompt) {
     
     while (1) {
         printf("%s", prompt);
-        if (scanf("%d", &choice) == 1) {
+        int scanned = scanf("%d", &choice);
+        if (scanned == EOF) {
+            // No more input (e.g. data piped without arguments): stop instead of looping
+            printf("\nEnd of input.\n");
+            exit(EXIT_SUCCESS);
+        }
+        if (scanned == 1) {
             if (choice >= min && choice <= max) {
                 break;
             } else {